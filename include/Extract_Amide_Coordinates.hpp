@@ -8,7 +8,14 @@ struct AmideIEntry {
     Atom C, O, N;
 };
 
-std::vector<AmideIEntry> Extract_Amide_Coordinates(const std::vector<Atom>& atoms);
+// One amide per peptide bond, in file order: C and O of residue i with N
+// of the next residue of the same chain, if that N is bonded to the C.
+// A chain that ends in OXT gives one more entry (C, O, OXT) for its last
+// residue. Residues are runs of atoms with the same chain / number /
+// insertion code, indexed in one pass (O(N_atoms)). With report set, chain
+// breaks are printed as warnings and every chain is summarized.
+std::vector<AmideIEntry> Extract_Amide_Coordinates(const std::vector<Atom>& atoms,
+                                                   bool report = false);
 
 #endif
 
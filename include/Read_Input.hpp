@@ -2,11 +2,17 @@
 #define READ_INPUT_HPP
 
 #include <string>
+#include <utility>
+#include <vector>
+#include "frequency_map.hpp"
+#include "lattice_sum.hpp"
 
 struct InputParams {
     std::string pdbFile;
     double centerFreq;
     int layer;
+    int amide_first = 1;              // amide_range: 1-based, in extraction order
+    int amide_last = 5;               //   0 = through the last amide ("all")
     double tilt_start; 
     double tilt_end; 
     int tilt_points; 
@@ -21,9 +27,33 @@ struct InputParams {
     double spec_range_step;  
     std::string SpectraFolder;      
     std::string SpectraStorePrefix;  
+    bool trajectory = false;          // PDB_file is a multi-model trajectory
+    bool write_frame_spectra = true;  // trajectory: also write per-frame spectra
+    double disorder_sigma = 0.0;      // static site-energy disorder (cm^-1)
+    int disorder_samples = 1;         // ensemble size (>1 enables the batched solver)
+    unsigned disorder_seed = 1;
+    std::string coupling_model = "tdc"; // tdc | tdc_nn (NN dihedral map for bonded pairs)
+    std::string nn_coupling_map;        // tdc_nn: phi/psi/J table
+    Lattice2D lattice;                  // tdc_periodic: monolayer lattice vectors, sum cutoff
+    bool freq_map = false;              // electrostatic site frequencies
+    FrequencyMapParams freq_map_params; // cutoff and C/O/N coefficients
+    std::string hamiltonian_solver = "dense"; // dense | lanczos (large systems, tree couplings)
+    int lanczos_steps = 20;             // lanczos: block steps (12 exciton states each)
+    double bh_theta = 0.5;              // lanczos: Barnes-Hut opening angle
+    int symmetry_n = 1;                 // >1: Cn homo-oligomer, SFG-active irreps only
+    Vec3 symmetry_axis = {0.0, 0.0, 0.0}; // Cn axis (PDB frame), zero = detect
+    double symmetry_tol = 0.5;          // Å, allowed deviation from exact symmetry
+    std::string r3_source = "analytic"; // analytic (3×3 rotation of mu/alpha) | database (27×27 table)
+    std::vector<std::string> sfg_elements = { "ssp", "ppp" }; // spectra written, in column order
+    bool debug_output = false;          // dump chi_mol / chi_lab per angle to debug1/
+    std::string structure_cache = "none"; // none | directory of binary site caches (static PDB)
 };
 
-InputParams Read_Input(const std::string &filename);
+// Throws std::runtime_error (message without the "ERROR: " prefix) if the
+// file cannot be read or an entry is missing or invalid. overrides replace
+// (or add) entries of the file, e.g. {"PDB_file", "pose12.pdb"}.
+InputParams Read_Input(const std::string &filename,
+                       const std::vector<std::pair<std::string, std::string>> &overrides = {});
 
 #endif
 
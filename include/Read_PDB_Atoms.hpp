@@ -1,16 +1,69 @@
 #ifndef READ_PDB_ATOMS_HPP
 #define READ_PDB_ATOMS_HPP
 
-#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <ostream>
 #include <string>
+#include <vector>
+
+// Short fixed-column PDB name (atom or residue), spaces removed and stored
+// inline: no heap allocation per atom, and Atom stays trivially copyable.
+struct PDBName {
+    char s[8] = {};
+
+    PDBName() = default;
+    PDBName(const char* p, std::size_t n) {
+        std::size_t k = 0;
+        for (std::size_t i = 0; i < n && k < sizeof(s) - 1; i++)
+            if (p[i] != ' ') s[k++] = p[i];
+    }
+
+    const char* c_str() const { return s; }
+    std::string str() const { return s; }
+    bool empty() const { return s[0] == '\0'; }
+    char operator[](std::size_t i) const { return s[i]; }
+
+    bool operator==(const char* o) const { return std::strcmp(s, o) == 0; }
+    bool operator!=(const char* o) const { return !(*this == o); }
+    bool operator==(const PDBName& o) const { return std::memcmp(s, o.s, sizeof(s)) == 0; }
+    bool operator!=(const PDBName& o) const { return !(*this == o); }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const PDBName& n) { return os << n.s; }
 
 struct Atom {
-    std::string name;   // AtomName (C, O, N, CA, etc.)
-    int serial;         // NEW: PDB Atom Serial Number
+    PDBName name;       // AtomName (C, O, N, CA, etc.)
+    int serial;         // NEW: PDB Atom Serial Number (-1 if not decimal, e.g. > 99999)
+    PDBName resName;    // Residue name (ALA, HOH, ...)
+    char chain;         // Chain identifier (' ' if none)
     int resID;          // Residue Number
+    char iCode;         // Insertion code (' ' if none)
     double x, y, z;     // Coordinates
 };
 
-std::vector<Atom> Read_PDB_Atoms(const std::string &pdbFile);
+// Residue identity across chains: chain, residue number, insertion code
+inline long long residue_key(const Atom& a)
+{
+    return ((long long)(unsigned char)a.chain << 40) |
+           ((long long)(unsigned char)a.iCode << 32) |
+           (unsigned int)a.resID;
+}
+
+// Atoms the amide-I sites are built from (C, O, N, CA and the C-terminal
+// OXT); everything else only matters for the electrostatic frequency map
+bool is_backbone_atom(const PDBName& name);
+
+// Parse one fixed-column ATOM/HETATM record of length len (no newline).
+// Returns false for any other record type (or a truncated line), and for
+// non-backbone atoms if backbone_only is set. Throws std::runtime_error if
+// the residue number or a coordinate of an atom record is not a number.
+bool Parse_PDB_Atom_Line(const char* line, std::size_t len, Atom &a,
+                         bool backbone_only = false);
+
+// Memory-mapped read of all ATOM/HETATM records in file order (backbone_only:
+// see above). Throws std::runtime_error if the file cannot be opened or a
+// record is malformed.
+std::vector<Atom> Read_PDB_Atoms(const std::string &pdbFile, bool backbone_only = false);
 
 #endif
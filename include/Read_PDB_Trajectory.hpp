@@ -0,0 +1,34 @@
+#ifndef READ_PDB_TRAJECTORY_HPP
+#define READ_PDB_TRAJECTORY_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Read_PDB_Atoms.hpp"
+#include "mapped_file.hpp"
+
+// Streams a multi-model PDB trajectory one frame at a time.
+// Frames are delimited by MODEL/ENDMDL records; a file without MODEL
+// records is treated as a single frame. The file is memory-mapped and
+// only one frame of atoms is held at a time.
+class PDBTrajectoryReader {
+public:
+    // backbone_only: keep only the atoms the amide-I sites need.
+    // Throws std::runtime_error if the file cannot be opened.
+    explicit PDBTrajectoryReader(const std::string &pdbFile, bool backbone_only = false);
+
+    // Read the next frame into `atoms` (cleared first).
+    // Returns false once the trajectory is exhausted.
+    bool next_frame(std::vector<Atom> &atoms);
+
+    int frames_read() const { return nframes; }
+
+private:
+    MappedFile  file;
+    std::size_t pos = 0;          // start of the next unread line
+    std::string fname;
+    bool        backbone_only;
+    int         nframes = 0;
+};
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef AMIDEI_SITE_KERNEL_HPP
+#define AMIDEI_SITE_KERNEL_HPP
+
+#include <vector>
+#include "Extract_Amide_Coordinates.hpp"
+#include "amide_mode_table.hpp"
+
+// -----------------------------------------------------------------------------
+// Fused geometry -> local frame -> property kernel.
+//
+// One vectorized pass from the C / O / N coordinates of each amide to its
+// vibration centre, transition dipole and Raman tensor, the same quantities
+// as get_amideI_geometry + get_local_frame + get_amideI_properties without
+// the intermediate per-mode structs. The molecular dipole and Raman tensor
+// are constants; with the frame T = [X Y Z] the rotated tensor is
+//
+//   T A T' = a_xx X X' + a_yy Y Y' + a_zz Z Z' + a_yz (Y Z' + Z Y')
+//
+// since the 34 deg Raman rotation is about the molecular x axis.
+//
+// Rows 0 … amide.size()-1 of the centre, dipole and alpha arrays of modes
+// are written; modes must already have at least that many rows. A
+// zero-length C=O or C-N bond, or collinear C, O, N, has no frame. The
+// vector loop has no early exit: such a row is computed with a clamped
+// inverse norm, and once its tile (SITE_TILE amides) is done the index of
+// the first degenerate amide is returned. Otherwise -1. The caller decides
+// how to report it; rows from that index on are not meaningful.
+// -----------------------------------------------------------------------------
+int amideI_site_kernel(const std::vector<AmideIEntry>& amide,
+                       AmideModeTable& modes);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef AMIDE_MODE_TABLE_HPP
+#define AMIDE_MODE_TABLE_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "helper_vec3.hpp"
+
+// -----------------------------------------------------------------------------
+// Amide-I modes as a structure of arrays: one contiguous array per
+// quantity, each value stored once. Built by Get_AmideI_Multi (or read
+// from the structure cache) and read directly by the Hamiltonian,
+// the coupling models and the symmetry detection.
+// -----------------------------------------------------------------------------
+struct AmideModeTable {
+    int N = 0;
+
+    std::vector<double> x, y, z;          // vibration centre (Å, PDB frame)
+    std::vector<double> nn_phi, nn_psi;   // deg, residue joining mode i to i+1 (NaN: none)
+    std::vector<double> mux, muy, muz;    // transition dipole
+    std::vector<double> alpha;            // N×9, Raman tensor of mode i, col-major 3×3
+    std::vector<double> freq;             // site frequency (cm^-1)
+    std::vector<double> anharm;           // anharmonicity (cm^-1)
+
+    void resize(int n)
+    {
+        N = n;
+        for (auto* v : { &x, &y, &z, &mux, &muy, &muz, &freq, &anharm })
+            v->assign(n, 0.0);
+        nn_phi.assign(n, NAN);
+        nn_psi.assign(n, NAN);
+        alpha.assign((std::size_t)9 * n, 0.0);
+    }
+
+    Vec3 center(int i) const { return { x[i], y[i], z[i] }; }
+    Vec3 mu(int i)     const { return { mux[i], muy[i], muz[i] }; }
+    const double* alpha_of(int i) const { return &alpha[(std::size_t)9 * i]; }
+};
+
+#endif
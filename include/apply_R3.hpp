@@ -3,6 +3,7 @@
 
 #include <array>
 #include "load_R3ZXZ1.hpp"   // for R3Matrix
+#include "helper_vec3.hpp"
 
 // Apply R3 (27×27) to a single chi vector (27×1)
 std::array<double,27> apply_R3_single(
@@ -10,4 +11,86 @@ std::array<double,27> apply_R3_single(
     const std::array<double,27>& chi_in
 );
 
+
+// -----------------------------------------------------------------------------
+// Factorized R3. For twist psi and tilt theta the database holds
+//
+//   R3 = < (Rz(phi) Rx(theta) Rz(psi)) ⊗ 3 >_phi     (chi index i + 3j + 9l)
+//
+// (the azimuthal average over the surface normal). So instead of the
+// 27×27 mat-vec, μ and α are rotated by R' = Rx(theta) Rz(psi) (3×3) and
+// the phi average keeps the 13 lab components invariant about z.
+// -----------------------------------------------------------------------------
+struct R3Rotation {
+    double R[3][3];     // R' (row-major)
+};
+
+R3Rotation make_R3_rotation(double psi_deg, double theta_deg);
+
+// Same as apply_R3_single(R3, outer product of alpha and mu)
+std::array<double,27> apply_R3_rotation(
+    const R3Rotation& R,
+    const std::array<double,9>& alpha,    // col-major 3×3
+    const Vec3& mu
+);
+
+// Only the chi_lab elements idx[0 .. n) of apply_R3_rotation, into out
+void apply_R3_rotation_elements(
+    const R3Rotation& R,
+    const std::array<double,9>& alpha,
+    const Vec3& mu,
+    const int* idx,
+    int n,
+    double* out
+);
+
+
+// -----------------------------------------------------------------------------
+// Sparse R3 for general χ vectors. The azimuthal average leaves 14 of the
+// 27 rows zero, and the other 13 are ± one of 7 distinct rows
+// (zzz, xxz, xzx, zxx, xyz, xzy, zxy). The pattern is fixed at compile
+// time: R3_SPARSE_ROW[i] is the distinct row that χ_lab[i] uses (-1 if
+// zero), and R3_SPARSE_SIGN[i] is its sign. Applying R3 then costs 7×27
+// instead of 27×27 multiply-adds.
+// -----------------------------------------------------------------------------
+constexpr int R3_SPARSE_NROW = 7;
+
+// distinct rows: 0 zzz, 1 xxz, 2 xzx, 3 zxx, 4 xyz, 5 xzy, 6 zxy
+constexpr int R3_SPARSE_ROW[27] = {
+//  xx  yx  zx  xy  yy  zy  xz  yz  zz     (α index i + 3j)
+    -1, -1,  3, -1, -1,  6,  2,  5, -1,    // μ x
+    -1, -1,  6, -1, -1,  3,  5,  2, -1,    // μ y
+     1,  4, -1,  4,  1, -1, -1, -1,  0     // μ z
+};
+
+constexpr double R3_SPARSE_SIGN[27] = {
+     0,  0,  1,  0,  0, -1,  1, -1,  0,
+     0,  0,  1,  0,  0,  1,  1,  1,  0,
+     1, -1,  0,  1,  1,  0,  0,  0,  1
+};
+
+struct R3Sparse {
+    double row[R3_SPARSE_NROW][27];
+};
+
+// From the factorized rotation (no table needed)
+R3Sparse make_R3_sparse(const R3Rotation& R);
+
+// From a table entry (its 7 distinct rows)
+R3Sparse make_R3_sparse(const R3Matrix& R);
+
+// Same as apply_R3_single
+std::array<double,27> apply_R3_sparse(
+    const R3Sparse& R,
+    const std::array<double,27>& chi_in
+);
+
+// n χ vectors at once: chi_in, chi_out n×27 row-major (one GEMM)
+void apply_R3_sparse_batch(
+    const R3Sparse& R,
+    const double* chi_in,
+    double* chi_out,
+    int n
+);
+
 #endif
@@ -0,0 +1,50 @@
+#ifndef BATCH_DRIVER_HPP
+#define BATCH_DRIVER_HPP
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "Read_Input.hpp"
+
+// -----------------------------------------------------------------------------
+// Multi-structure batch mode (sfg_simulator --batch <manifest> [threads]).
+//
+// The manifest lists one job per line: an input file followed by entries
+// that override it, in input-file syntax without spaces around '='
+// (quote values that contain spaces):
+//
+//   # input file        overrides
+//   input/input.txt     PDB_file=poses/p1.pdb
+//   input/input.txt     PDB_file=poses/p2.pdb width=8 sfg_elements="ssp ppp"
+//   input/helix.txt
+//
+// A job that overrides PDB_file but not SpectraStorePrefix writes to
+// <prefix>_<PDB stem>, so one input file can serve thousands of structures.
+// Two jobs writing to the same folder and prefix are an error.
+//
+// All jobs share one work-stealing pool: a structure task builds the
+// SFGSession (PDB, mode table, excitons) and then submits the orientation
+// grid in blocks, which its worker runs first and idle workers steal. Small
+// and large structures thus balance on one node. Each worker runs its
+// tasks single-threaded (OpenMP), and one R3 table is shared by all jobs.
+// Spectra files are the same as those of a single run; debug_output
+// is ignored. A failed job is reported and the others continue.
+// -----------------------------------------------------------------------------
+struct BatchJob {
+    std::string input_file;
+    std::vector<std::pair<std::string, std::string>> overrides;
+    int line = 0;                       // manifest line, for messages
+};
+
+// Throws std::runtime_error if the manifest cannot be read or a line is
+// malformed
+std::vector<BatchJob> read_batch_manifest(const std::string& manifest);
+
+// Input of one job: the input file with the overrides and the default
+// prefix applied. Throws std::runtime_error (Read_Input errors, trajectory)
+InputParams read_batch_job(const BatchJob& job);
+
+// Returns the process exit code: 0 if every job succeeded
+int run_batch(const std::string& manifest, int n_threads);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+// Blocking FIFO with a fixed capacity, used to hand frames between
+// pipeline stages. push() blocks while full, pop() blocks while empty.
+// After close(), pop() drains the remaining items and then returns false.
+template<typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(std::size_t capacity) : cap(capacity) {}
+
+    void push(T item)
+    {
+        std::unique_lock<std::mutex> lock(m);
+        not_full.wait(lock, [&] { return q.size() < cap || closed; });
+        if (closed) return;
+        q.push_back(std::move(item));
+        not_empty.notify_one();
+    }
+
+    bool pop(T &item)
+    {
+        std::unique_lock<std::mutex> lock(m);
+        not_empty.wait(lock, [&] { return !q.empty() || closed; });
+        if (q.empty()) return false;
+        item = std::move(q.front());
+        q.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m);
+        closed = true;
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+private:
+    std::size_t             cap;
+    std::deque<T>           q;
+    std::mutex              m;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+    bool                    closed = false;
+};
+
+#endif
@@ -2,23 +2,49 @@
 #define CHI2_MATLAB_HPP
 
 #include <array>
+#include <string>
 #include <vector>
 #include "helper_vec3.hpp"
 #include "hamiltonian_equiv_matlab.hpp"
 
 struct R3Matrix;
+struct R3Rotation;
+
+// -----------------------------------------------------------------------------
+// Which lab-frame χ elements the spectra need. Each entry is a polarization
+// combination (ssp, sps, pss, ppp; SFG-vis-IR, p taken as z only, as without
+// Fresnel factors) or a tensor element such as "xzx" (χ_ijl = α_ij μ_l,
+// chi_lab index i + 3j + 9l). Only these rows of R3 are evaluated.
+// -----------------------------------------------------------------------------
+struct Chi2Plan {
+    std::vector<int> elements;          // chi_lab indices, spectrum order
+    std::vector<std::string> labels;    // output column names, e.g. "SSP(yyz)"
+    bool full = false;                  // also keep all 27 χ(mol) / χ(lab)
+};
+
+// Returns false with a message on std::cerr for an unknown entry
+bool make_chi2_plan(const std::vector<std::string>& requested, bool full, Chi2Plan& plan);
 
 struct Chi2Result {
     int N = 0;
+    int nsel = 0;                                // plan.elements.size()
 
     std::vector<double> freq;                    // size N
-    std::vector<std::array<double,27>> chi_mol;  // χ(mol) size N
-    std::vector<std::array<double,27>> chi_lab;  // χ(lab) size N
+    std::vector<double> chi_sel;                 // N × nsel, plan order
+    std::vector<std::array<double,27>> chi_mol;  // χ(mol) size N (plan.full only)
+    std::vector<std::array<double,27>> chi_lab;  // χ(lab) size N (plan.full only)
 };
 
 Chi2Result compute_chi2_matlab(
     const HamiltonianEquivResult& H,
-    const R3Matrix& R);
+    const R3Matrix& R,
+    const Chi2Plan& plan);
+
+// Same, with the factorized R3 (3×3 rotation of μ and α, see apply_R3.hpp)
+Chi2Result compute_chi2_matlab(
+    const HamiltonianEquivResult& H,
+    const R3Rotation& R,
+    const Chi2Plan& plan);
 
 #endif
 
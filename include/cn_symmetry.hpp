@@ -0,0 +1,53 @@
+#ifndef CN_SYMMETRY_HPP
+#define CN_SYMMETRY_HPP
+
+#include <vector>
+#include "helper_vec3.hpp"
+#include "amide_mode_table.hpp"
+
+// -----------------------------------------------------------------------------
+// Cn-symmetric homo-oligomers.
+//
+// The N = n·m sites are n subunits of m sites each, stored subunit by
+// subunit, with subunit p+1 = C subunit p for the rotation C by 2π/n about
+// `axis` through `center`. H then commutes with C and splits into irreps
+// k = 0 … n-1 of size m (basis  sum_p e^{2πi pk/n} |s,p> / sqrt(n)).
+//
+// A dipole carries only k = 0 (along the axis) and k = ±1 (across it), a
+// Raman tensor k = 0, ±1, ±2, so only k = 0 and the ±1 pair have SFG
+// intensity. Those are built in a real basis (cos / sin combinations, so
+// k = ±1 is one real 2m block) and diagonalized with dsyev: at most 3m
+// states instead of n·m, i.e. ~n^3/27 less work for the solve.
+// -----------------------------------------------------------------------------
+struct CnSymmetry {
+    int  n = 1;
+    Vec3 center = {0.0, 0.0, 0.0};
+    Vec3 axis   = {0.0, 0.0, 1.0};   // unit; subunit p+1 = rotation of p by +2π/n
+};
+
+// Finds center (site centroid) and axis (axis_hint if nonzero, otherwise
+// from the subunit centroids) and checks that every site and dipole maps
+// onto its partner in the next subunit within tol (Å, and tol/Å relative
+// for the dipoles). Returns false with a message on std::cerr otherwise.
+bool detect_cn_symmetry(
+    const AmideModeTable& modes,
+    int n,
+    const Vec3& axis_hint,
+    double tol,
+    CnSymmetry& sym
+);
+
+// Projects H (N×N row-major, diagonal + lower triangle) and the site
+// moments M (N×12) onto the real symmetry-adapted basis of the SFG-active
+// irreps. The subunit blocks of H are averaged over the n equivalent
+// positions, so small deviations from exact symmetry are symmetrized.
+// Hb: K×K (full), Mb: K×12. Returns K.
+int cn_sfg_blocks(
+    const CnSymmetry& sym,
+    const std::vector<double>& H,
+    const std::vector<double>& M,
+    std::vector<double>& Hb,
+    std::vector<double>& Mb
+);
+
+#endif
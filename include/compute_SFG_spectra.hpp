@@ -8,8 +8,7 @@
 
 struct SpectrumResult {
     std::vector<double> freq;
-    std::vector<double> I_ssp;   // yyz = index 22
-    std::vector<double> I_ppp;   // zzz = index 26
+    std::vector<std::vector<double>> I;   // one spectrum per Chi2Plan element
 };
 
 
@@ -1,6 +1,8 @@
 #ifndef COMPUTE_DIPOLE_COUPLING_HPP
 #define COMPUTE_DIPOLE_COUPLING_HPP
 
+#include <cstdint>
+#include <cstring>
 #include <vector>
 #include "helper_vec3.hpp"
 
@@ -13,5 +15,43 @@ double compute_dipole_coupling(
     double prefactor          // MATLAB beta prefactor (cm⁻¹·Å³)
 );
 
+// 1/sqrt(x) for x > 0: bit-level seed (~3e-2), four Newton steps -> ~1e-16.
+// No sqrt/div, so loops calling it vectorize without -ffast-math.
+inline double rsqrt_newton(double x)
+{
+    std::int64_t bits;
+    std::memcpy(&bits, &x, sizeof bits);
+    bits = 0x5fe6eb50c7b537a9LL - (bits >> 1);
+    double r;
+    std::memcpy(&r, &bits, sizeof r);
+
+    const double h = 0.5 * x;
+    r = r * (1.5 - h * r * r);
+    r = r * (1.5 - h * r * r);
+    r = r * (1.5 - h * r * r);
+    r = r * (1.5 - h * r * r);
+    return r;
+}
+
+// Site positions / transition dipoles as structure-of-arrays, so that the
+// coupling of site i to a whole block of sites j is one SIMD loop.
+struct DipoleSitesSoA {
+    std::vector<double> x, y, z;          // vibration centres (Å)
+    std::vector<double> mux, muy, muz;    // transition dipoles
+};
+
+// All pair couplings at once: H(i,j) = compute_dipole_coupling(mu_i, mu_j,
+// R_i - R_j, -, no cutoff, prefactor) for j < i, with H N×N row-major.
+// Only the strictly lower triangle is written (mirroring it costs as much as
+// computing it); the diagonal and upper triangle are not touched.
+// 1/R uses an rsqrt bit seed plus Newton steps (full double accuracy);
+// rows are split into tiles over OpenMP threads.
+void build_dipole_coupling_matrix(
+    const DipoleSitesSoA& sites,
+    double prefactor,
+    double* H,
+    int N
+);
+
 #endif
 
@@ -0,0 +1,151 @@
+#ifndef COUPLING_MODEL_HPP
+#define COUPLING_MODEL_HPP
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "amide_mode_table.hpp"
+#include "compute_dipole_coupling.hpp"
+#include "lattice_sum.hpp"
+
+// -----------------------------------------------------------------------------
+// Off-diagonal one-exciton couplings J_ij.
+//
+// A model fills the strictly lower triangle H(i,j), j < i, of the N×N
+// row-major Hamiltonian for all pairs in one call, so each model can use
+// its own vectorized kernel. The diagonal already holds the site
+// frequencies; a model may add to it (periodic self-images):
+//
+//   tdc           transition dipole coupling for every pair
+//   tdc_nn        TDC, except covalently bonded neighbours (i, i+1), which
+//                 take J(phi, psi) from a nearest-neighbour map of the
+//                 joining residue
+//   tdc_periodic  TDC lattice-summed over a 2D-periodic monolayer, k = 0
+//                 block (see lattice_sum.hpp)
+// -----------------------------------------------------------------------------
+class CouplingModel {
+public:
+    virtual ~CouplingModel() = default;
+
+    virtual const char* name() const = 0;
+
+    virtual void fill_couplings(
+        const AmideModeTable& modes,
+        const DipoleSitesSoA& sites,
+        double* H,
+        int N
+    ) const = 0;
+};
+
+
+// Transition dipole coupling (MATLAB prefactor, no cutoff)
+class TDCCoupling : public CouplingModel {
+public:
+    explicit TDCCoupling(double prefactor = default_prefactor());
+
+    const char* name() const override { return "tdc"; }
+
+    void fill_couplings(
+        const AmideModeTable& modes,
+        const DipoleSitesSoA& sites,
+        double* H,
+        int N
+    ) const override;
+
+    // Dipole–dipole coupling prefactor (from MATLAB code)
+    static double default_prefactor();
+
+private:
+    double prefactor_;
+};
+
+
+// -----------------------------------------------------------------------------
+// Periodic bicubic interpolation on a regular (phi, psi) grid in degrees.
+// Cell coefficients are precomputed at load time (derivatives by central
+// differences), so one evaluation is an index computation and a 4×4 Horner.
+//
+// Map file: one "phi psi J" line per grid point (deg, deg, cm^-1), any
+// order, regular spacing covering [-180, 180) in both angles; '#' starts
+// a comment. Angles are folded into [-180, 180), so a map that also lists
+// +180 is accepted if those rows repeat the -180 values.
+// -----------------------------------------------------------------------------
+class PeriodicBicubic {
+public:
+    // Throws std::runtime_error if the file is missing or not a complete
+    // regular grid.
+    void load(const std::string& filename);
+
+    // out[k] = f(phi[k], psi[k]) for k < n
+    void eval(const double* phi, const double* psi, double* out, int n) const;
+
+    int n_phi() const { return nphi_; }
+    int n_psi() const { return npsi_; }
+
+private:
+    int nphi_ = 0, npsi_ = 0;
+    double phi0_ = 0.0, psi0_ = 0.0;
+    double hphi_ = 1.0, hpsi_ = 1.0;
+    std::vector<double> coef_;     // 16 per cell: a[m][n] t^m s^n
+};
+
+
+// TDC plus a nearest-neighbour dihedral map for bonded pairs
+class NNMapCoupling : public CouplingModel {
+public:
+    explicit NNMapCoupling(PeriodicBicubic map) : map_(std::move(map)) {}
+
+    const char* name() const override { return "tdc_nn"; }
+
+    void fill_couplings(
+        const AmideModeTable& modes,
+        const DipoleSitesSoA& sites,
+        double* H,
+        int N
+    ) const override;
+
+private:
+    TDCCoupling tdc_;
+    PeriodicBicubic map_;
+};
+
+
+// k = 0 TDC of a 2D-periodic monolayer. The lattice sum depends only on
+// the sites, so the last result is kept and reused while the sites do not
+// change (every orientation of a static structure).
+class PeriodicTDCCoupling : public CouplingModel {
+public:
+    explicit PeriodicTDCCoupling(const Lattice2D& lattice,
+                                 double prefactor = TDCCoupling::default_prefactor());
+
+    const char* name() const override { return "tdc_periodic"; }
+
+    void fill_couplings(
+        const AmideModeTable& modes,
+        const DipoleSitesSoA& sites,
+        double* H,
+        int N
+    ) const override;
+
+private:
+    Lattice2D lattice_;
+    double prefactor_;
+
+    mutable std::mutex cache_mutex_;
+    mutable DipoleSitesSoA cache_sites_;
+    mutable std::vector<double> cache_J_;   // lower triangle + diagonal shift
+};
+
+
+// Model selected in input.txt (coupling_model / nn_coupling_map /
+// lattice_*). Throws std::runtime_error on an unknown model name or an
+// unreadable map.
+std::unique_ptr<CouplingModel> make_coupling_model(
+    const std::string& model,
+    const std::string& nn_map_file,
+    const Lattice2D& lattice = Lattice2D()
+);
+
+#endif
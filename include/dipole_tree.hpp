@@ -0,0 +1,52 @@
+#ifndef DIPOLE_TREE_HPP
+#define DIPOLE_TREE_HPP
+
+#include <vector>
+#include "compute_dipole_coupling.hpp"
+
+// -----------------------------------------------------------------------------
+// Barnes–Hut evaluation of the transition-dipole coupling operator
+//
+//   y_i = sum_{j != i} J_ij x_j,   J_ij = prefactor * mu_i . T(R_i - R_j) mu_j
+//   T(d) p = p / d^3 - 3 d (d.p) / d^5
+//
+// without forming J. Sites are sorted into an octree; for a given x every
+// node carries the total dipole P = sum x_j mu_j and its first moment
+// Q = sum x_j mu_j (R_j - c)^T about the node centre c. A node of size s
+// seen from distance d with s < theta * d is replaced by this expansion
+// (error O(theta^2)); closer nodes are opened, leaves are summed directly.
+// One apply costs O(N log N); theta -> 0 reproduces the dense sum.
+// -----------------------------------------------------------------------------
+class DipoleTreeOperator {
+public:
+    DipoleTreeOperator(const DipoleSitesSoA& sites, double prefactor, double theta);
+
+    int size() const { return n_; }
+
+    // y = J x (x, y of length size())
+    void apply(const double* x, double* y) const;
+
+private:
+    struct Node {
+        int begin = 0, end = 0;        // range in order_
+        int child = -1;                // first child, children are contiguous
+        int nchild = 0;
+        double cx = 0.0, cy = 0.0, cz = 0.0;   // centroid of the sites
+        double size = 0.0;             // diameter of the sphere around c holding all sites
+    };
+
+    void build(int self, int begin, int end,
+               double x0, double y0, double z0, double edge, int depth);
+
+    int n_ = 0;
+    double prefactor_ = 0.0;
+    double theta2_ = 0.0;
+
+    std::vector<Node> nodes_;          // nodes_[0] is the root
+    std::vector<int> order_;           // site indices in tree order
+
+    // site data in tree order (SoA)
+    std::vector<double> x_, y_, z_, mux_, muy_, muz_;
+};
+
+#endif
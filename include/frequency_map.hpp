@@ -0,0 +1,41 @@
+#ifndef FREQUENCY_MAP_HPP
+#define FREQUENCY_MAP_HPP
+
+#include <vector>
+#include "Read_PDB_Atoms.hpp"
+#include "Extract_Amide_Coordinates.hpp"
+
+// -----------------------------------------------------------------------------
+// Electrostatic amide-I frequency map.
+//
+//   freq_k = center_freq + cC * E_C + cO * E_O + cN * E_N
+//
+// E_a is the electric field (atomic units) at atom a of amide k, projected
+// on its C=O unit vector. It comes from the partial charges of all atoms
+// within `cutoff`, except those in the two residues the amide belongs to.
+// The defaults are the C/N coefficients of the Skinner-group protein
+// map (Lin et al., JPCB 2009: 1684 + 7729 E_C - 3576 E_N); the intercept is
+// replaced by center_freq from the input.
+//
+// Charges are looked up in a united-atom table (backbone, ionized side
+// chains, water), see partial_charge(). Neighbour search uses a cell list
+// with cell size = cutoff, so the cost is O(N_atoms) at fixed density.
+// -----------------------------------------------------------------------------
+struct FrequencyMapParams {
+    double cutoff = 20.0;      // Å
+    double coef_C = 7729.0;    // cm^-1 per a.u. of field
+    double coef_O = 0.0;
+    double coef_N = -3576.0;
+};
+
+// Partial charge (e) of a PDB atom; 0 for atoms not in the table
+double partial_charge(const Atom& a);
+
+// Frequency shift (cm^-1) of every amide
+std::vector<double> electrostatic_frequency_shifts(
+    const std::vector<AmideIEntry>& amides,
+    const std::vector<Atom>& atoms,
+    const FrequencyMapParams& params
+);
+
+#endif
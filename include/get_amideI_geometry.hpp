@@ -4,6 +4,7 @@
 #include <vector>
 #include "Extract_Amide_Coordinates.hpp"   // defines AmideIEntry
 #include "helper_vec3.hpp"
+#include "amide_mode_table.hpp"
 
 
 // Stores geometric information needed for later SFG & Hamiltonian calculations
@@ -11,10 +12,22 @@ struct AmideIGeo {
     Vec3 CO_vector;                // normalized CO direction
     Vec3 CN_vector;                // normalized CN direction
     Vec3 vibration_center_coord;   // amide-I vibrational center
+
+    // Backbone phi/psi (deg) of the residue joining this amide to the next
+    // one; NaN if the next amide is not covalently bonded to this one
+    double nn_phi = NAN;
+    double nn_psi = NAN;
 };
 
 // Main API: compute geometry for each amide residue
 std::vector<AmideIGeo> get_amideI_geometry(
     const std::vector<AmideIEntry>& amideAtoms);
 
+// Fill nn_phi / nn_psi of rows 0 … amideAtoms.size()-1 from the CA atoms
+// in atoms (row k <-> amideAtoms[k])
+void assign_nn_dihedrals(
+    AmideModeTable& modes,
+    const std::vector<AmideIEntry>& amideAtoms,
+    const std::vector<Atom>& atoms);
+
 #endif
@@ -4,24 +4,28 @@
 #include <vector>
 #include <array>
 #include "helper_vec3.hpp"
-#include "get_amideI_geometry.hpp"
-#include "get_amideI_properties.hpp"
-#include "initialize_amideI_frequency.hpp"
+#include "amide_mode_table.hpp"
 #include "mualphagen.hpp"      
 
+class CouplingModel;
+struct CnSymmetry;
+
 // -----------------------------------------------------------------------------
 // Final output that matches MATLAB OneExcitonH.m
 // -----------------------------------------------------------------------------
 struct HamiltonianEquivResult {
-    int N = 0;
+    int N = 0;                               // number of excitons (Ritz states
+                                             // for the Lanczos path)
 
     // Sorted exciton frequencies
     std::vector<double> Sort_Ex_Freq;        // size N
 
     // Sorted eigenvectors (columns sorted with frequencies)
+    // Empty unless HamiltonianOptions::keep_eigenvectors is set.
     std::vector<double> Sort_V;              // N×N row-major
 
     // Rotated site dipoles μ_i (lab frame)
+    // Empty unless HamiltonianOptions::keep_site_properties is set.
     std::vector<Vec3> mu_rot;                // size N
 
     // Rotated Raman tensors α_i (lab frame), col-major 3×3 → 9 entries
@@ -34,15 +38,61 @@ struct HamiltonianEquivResult {
     std::vector<std::array<double,9>> alpha_ex;    // size N
 };
 
+// -----------------------------------------------------------------------------
+// Optional solver settings
+// -----------------------------------------------------------------------------
+struct HamiltonianOptions {
+    // Off-diagonal couplings. nullptr = transition dipole coupling.
+    const CouplingModel* coupling = nullptr;
+
+    // The spectra only need frequencies and exciton μ/α. Eigenvectors (N×N)
+    // and site properties are dropped unless asked for, so that peak memory
+    // stays at one N×N array (H, overwritten by dsyev) for large assemblies.
+    bool keep_eigenvectors    = false;
+    bool keep_site_properties = false;
+
+    // > 0: skip the dense N×N path and return a reduced set of Ritz
+    // excitons from this many block-Lanczos steps (12 states per step),
+    // with the couplings applied by a Barnes–Hut tree of opening angle
+    // tree_theta. For systems too large for dsyev; TDC couplings only,
+    // no eigenvectors.
+    int    lanczos_steps = 0;
+    double tree_theta    = 0.5;
+
+    // Cn-symmetric oligomer (detect_cn_symmetry): only the SFG-active
+    // irreps k = 0, ±1 are diagonalized, so N becomes (at most) 3 × the
+    // subunit size. No eigenvectors.
+    const CnSymmetry* symmetry = nullptr;
+};
+
 // -----------------------------------------------------------------------------
 // Main MATLAB-equivalent driver
 // -----------------------------------------------------------------------------
 HamiltonianEquivResult Hamiltonian_equiv_matlab(
-    const std::vector<AmideIGeo>& geo,
-    const std::vector<AmideIProps>& props,
-    const std::vector<AmideIFreq>& freqs,
+    const AmideModeTable& modes,
+    double tilt_deg,
+    double twist_deg,
+    const HamiltonianOptions& opts = HamiltonianOptions()
+);
+
+// -----------------------------------------------------------------------------
+// Batched driver for many independent small systems (structure libraries,
+// static-disorder ensembles). Items of equal N <= BATCHED_EIG_MAX_N are
+// diagonalized together by batched_syev_jacobi; larger ones go to dsyev.
+// Results are returned in item order.
+// -----------------------------------------------------------------------------
+// freq (size N) replaces modes->freq when set, so disorder realizations
+// share one table.
+struct HamiltonianBatchItem {
+    const AmideModeTable*      modes;
+    const std::vector<double>* freq = nullptr;
+};
+
+std::vector<HamiltonianEquivResult> Hamiltonian_equiv_matlab_batch(
+    const std::vector<HamiltonianBatchItem>& items,
     double tilt_deg,
-    double twist_deg
+    double twist_deg,
+    const HamiltonianOptions& opts = HamiltonianOptions()
 );
 
 #endif
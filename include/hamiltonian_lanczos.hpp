@@ -0,0 +1,37 @@
+#ifndef HAMILTONIAN_LANCZOS_HPP
+#define HAMILTONIAN_LANCZOS_HPP
+
+#include <vector>
+#include "compute_dipole_coupling.hpp"
+
+// -----------------------------------------------------------------------------
+// Reduced exciton set for large systems (thousands of sites and more).
+//
+// The spectra only need sum_k chi_k / (w - w_k + i G) with chi_k built from
+// the exciton moments V' M (M: N×12 site dipoles and Raman tensors). That
+// is the resolvent of H sandwiched between the 12 columns of M, which block
+// Lanczos started from M approximates by Gauss quadrature:
+//
+//   Q = orth[M, H M, H^2 M, ...],  T = Q' H Q = Z diag(theta) Z'
+//   Ritz "excitons": frequencies theta_l, moments (Z' Q' M)_l
+//
+// H is only applied to vectors: site frequencies on the diagonal plus the
+// tree-based dipole operator (DipoleTreeOperator), so neither H nor its
+// eigenvectors are ever stored. Memory is O(N * 12 * steps).
+// -----------------------------------------------------------------------------
+
+// site_freq: N diagonal entries; M: N×12 row-major site moments.
+// On return ritz (K) holds ascending Ritz frequencies and E (K×12, row-major)
+// their moments, K <= 12 * block_steps. Returns K.
+int lanczos_exciton_moments(
+    const DipoleSitesSoA& sites,
+    const std::vector<double>& site_freq,
+    const std::vector<double>& M,
+    double prefactor,
+    double theta,
+    int block_steps,
+    std::vector<double>& ritz,
+    std::vector<double>& E
+);
+
+#endif
@@ -69,5 +69,17 @@ inline Vec3 cross(const Vec3& a, const Vec3& b) {
     };
 }
 
+// ---------------------------------------------------------
+// Dihedral angle a-b-c-d in degrees, (-180, 180] (IUPAC sign)
+// ---------------------------------------------------------
+inline double dihedral_deg(const Vec3& a, const Vec3& b,
+                           const Vec3& c, const Vec3& d) {
+    Vec3 b1 = b - a, b2 = c - b, b3 = d - c;
+    Vec3 n1 = cross(b1, b2), n2 = cross(b2, b3);
+    double y = norm(b2) * dot(b1, n2);
+    double x = dot(n1, n2);
+    return std::atan2(y, x) * 180.0 / M_PI;
+}
+
 #endif
 
@@ -16,4 +16,14 @@ std::vector<AmideIFreq> initialize_amideI_frequency(
     double anharm = 12.0
 );
 
+// Static (inhomogeneous) disorder: n_samples copies of the site
+// frequencies `freq`, each site shifted by an independent Gaussian of
+// width sigma (cm^-1).
+std::vector<std::vector<double>> make_disorder_ensemble(
+    const std::vector<double>& freq,
+    double sigma,
+    int n_samples,
+    unsigned seed
+);
+
 #endif
@@ -0,0 +1,43 @@
+#ifndef LATTICE_SUM_HPP
+#define LATTICE_SUM_HPP
+
+#include <vector>
+#include "helper_vec3.hpp"
+#include "compute_dipole_coupling.hpp"
+
+// -----------------------------------------------------------------------------
+// 2D-periodic monolayer: the sites are one unit cell, repeated on the
+// lattice n1 a + n2 b (PDB frame, Å).
+//
+// SFG only sees the k = 0 (all cells in phase) excitons, and at k = 0 the
+// infinite Hamiltonian reduces to the unit-cell block
+//
+//   H0(i,j) = freq_i delta_ij + sum_L J(R_i - R_j + L)   (L != 0 if i == j)
+//
+// so only an N_modes × N_modes matrix is diagonalized; the spectra are per
+// unit cell. The 2D dipole sum converges absolutely, so no Ewald split is
+// needed: lattice points with |L| < cutoff are summed directly and the rest
+// is replaced by its continuum limit, for area A and layer normal n
+//
+//   sum_{|L| > cutoff} T(L) ~ pi / (A * cutoff) * (3 n n' - 1)
+//
+// which leaves an error O(cutoff^-2) instead of O(cutoff^-1).
+// -----------------------------------------------------------------------------
+struct Lattice2D {
+    Vec3 a = {0.0, 0.0, 0.0};
+    Vec3 b = {0.0, 0.0, 0.0};
+    double cutoff = 150.0;     // Å, direct-sum radius
+};
+
+// Lower triangle and diagonal of the lattice-summed coupling (H N×N
+// row-major): H(i,j) = sum_L J_ij(L) for j < i, H(i,i) += sum_{L != 0} J_ii(L).
+// The upper triangle is not touched.
+void build_periodic_dipole_coupling_matrix(
+    const DipoleSitesSoA& sites,
+    double prefactor,
+    const Lattice2D& lattice,
+    double* H,
+    int N
+);
+
+#endif
@@ -57,10 +57,9 @@ public:
         }
     }
 
-    R3Matrix get_R(double psi_deg, double theta_deg)
+    // Table entry get_R(psi_deg, theta_deg) reads: iTheta * nPsi + iPsi
+    size_t index(double psi_deg, double theta_deg) const
     {
-        std::lock_guard<std::mutex> lock(h5_mutex);
-        
         psi_deg   = fmod(fmod(psi_deg, 360.0) + 360.0, 360.0);
         theta_deg = fmod(fmod(theta_deg,180.0) + 180.0,180.0);
 
@@ -70,6 +69,17 @@ public:
         iPsi   = std::max(0, std::min((int)nPsi-1,   iPsi));
         iTheta = std::max(0, std::min((int)nTheta-1, iTheta));
 
+        return (size_t)iTheta * nPsi + iPsi;
+    }
+
+    R3Matrix get_R(double psi_deg, double theta_deg)
+    {
+        const size_t k = index(psi_deg, theta_deg);
+        const int iPsi   = k % nPsi;
+        const int iTheta = k / nPsi;
+
+        std::lock_guard<std::mutex> lock(h5_mutex);
+
         std::vector<double> buf(27 * 27);
 
         H5::DataSpace full = dset_R3.getSpace();
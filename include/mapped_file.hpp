@@ -0,0 +1,29 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory map of a whole file (POSIX mmap). The pages are
+// read on demand by the kernel, so parsing straight from data() avoids
+// the copies of an istream / getline loop.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false if the file cannot be opened or mapped
+    bool open(const std::string& path);
+
+    const char* data() const { return ptr; }
+    std::size_t size() const { return len; }
+
+private:
+    const char* ptr = nullptr;
+    std::size_t len = 0;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef MPI_DRIVER_HPP
+#define MPI_DRIVER_HPP
+
+// -----------------------------------------------------------------------------
+// MPI build (make mpi -> sfg_simulator_mpi, compiled with -DSFG_USE_MPI).
+//
+//   mpirun -n 4 ./sfg_simulator_mpi
+//       static structure of ./input/input.txt; the tilt/twist grid is split
+//       into contiguous blocks, one per rank. Every rank builds the session
+//       (the excitons do not depend on the orientation) and evaluates its
+//       block with OpenMP. Output: $SpectraFolder/$SpectraStorePrefix_sweep.txt
+//       with rows "tilt twist freq I_1 … I_n", twist-major.
+//
+//   mpirun -n 4 ./sfg_simulator_mpi --batch <manifest> [output_file]
+//       jobs of a batch manifest (see batch_driver.hpp), assigned to ranks
+//       largest first by estimated cost (PDB size × orientations × disorder
+//       samples). Output (default batch_spectra.txt): one block per job in
+//       manifest order, "# job <line> <input> <folder/prefix>", the column
+//       header and the rows as above; a failed job writes "# ERROR …".
+//
+// Each rank keeps only its own sessions, the R3 matrices of its angles
+// (read lazily from the HDF5 table) and its own results. The single output
+// file is written with one collective MPI-IO call (MPI_File_write_all
+// through a file view of each rank's byte ranges).
+// Several ranks on one machine:
+//   mpirun --oversubscribe -n 4 -x OMP_NUM_THREADS=1 ./sfg_simulator_mpi
+// -----------------------------------------------------------------------------
+#ifdef SFG_USE_MPI
+
+// Initializes and finalizes MPI; returns the process exit code
+int run_mpi(int argc, char** argv);
+
+#endif
+
+#endif
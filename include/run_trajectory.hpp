@@ -0,0 +1,30 @@
+#ifndef RUN_TRAJECTORY_HPP
+#define RUN_TRAJECTORY_HPP
+
+#include <vector>
+#include "Read_Input.hpp"
+#include "load_R3ZXZ1.hpp"
+#include "chi2_matlab.hpp"
+
+// Streaming trajectory driver.
+//
+// Three-stage pipeline over the frames of a multi-model PDB:
+//   reader thread : parse frame n+1 and build its amide-I sites
+//   main thread   : Hamiltonian of frame n (once), then chi2 + spectra
+//                   for every orientation (OpenMP over angles)
+//   writer thread : append the per-frame spectra of frame n-1
+// Stages are connected by bounded queues, so memory stays at a few frames
+// regardless of trajectory length. Time-averaged spectra are accumulated
+// on the fly and written per orientation when the trajectory ends.
+// Throws std::runtime_error for an unreadable trajectory or one without
+// frames.
+void run_trajectory_pipeline(
+    const InputParams& in,
+    const Chi2Plan& plan,
+    const std::vector<double>& freq_grid,
+    const std::vector<double>& tilt_vec,
+    const std::vector<double>& twist_vec,
+    R3Database* Rdb             // R3 table for r3_source = database, else nullptr
+);
+
+#endif
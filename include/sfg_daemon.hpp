@@ -0,0 +1,40 @@
+#ifndef SFG_DAEMON_HPP
+#define SFG_DAEMON_HPP
+
+#include <cstddef>
+#include <string>
+
+// -----------------------------------------------------------------------------
+// Local spectrum service (sfg_simulator --daemon <socket> [cache_MB]).
+//
+// Listens on a Unix domain socket and keeps one SFGSession per input file
+// resident, so repeated requests skip process startup, PDB parsing, the
+// exciton solve and the HDF5 open (one R3 table shared by all sessions).
+// Sessions are keyed by the canonical input path and the modification times
+// of the input and PDB files; editing either rebuilds the session. When the
+// sessions exceed cache_bytes the least recently used ones are evicted (the
+// one just used is always kept). Connections are served concurrently, so
+// OpenBLAS runs single-threaded for the life of the daemon.
+//
+// Line protocol, any number of requests per connection:
+//
+//   spectrum <input_file> <tilt> <twist>
+//   sweep <input_file>                    tilt/twist grid of the input file
+//   stats
+//   shutdown
+//
+// Reply: "OK <n>" followed by n lines, or "ERROR <message>". spectrum
+// lines are the spectrum file ("# freq  labels" header, then
+// "freq I_1 … I_n"); sweep lines are "# tilt twist freq labels" and
+// "tilt twist freq I_1 … I_n". Relative paths are resolved against the
+// working directory of the daemon.
+// -----------------------------------------------------------------------------
+struct DaemonOptions {
+    std::string socket_path;        // replaces a stale socket, nothing else
+    std::size_t cache_bytes = (std::size_t)1024 << 20;
+};
+
+// Serves until a shutdown request; returns the process exit code
+int run_sfg_daemon(const DaemonOptions& opts);
+
+#endif
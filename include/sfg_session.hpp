@@ -0,0 +1,100 @@
+#ifndef SFG_SESSION_HPP
+#define SFG_SESSION_HPP
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Read_Input.hpp"
+#include "amide_mode_table.hpp"
+#include "chi2_matlab.hpp"
+#include "hamiltonian_equiv_matlab.hpp"
+
+class R3Database;
+struct R3Matrix;
+
+// -----------------------------------------------------------------------------
+// Reusable simulation of one static structure (libsfg entry point).
+//
+// The constructor does everything that does not depend on the orientation:
+// parse the PDB (or read the structure cache), build the mode table, solve
+// the exciton problem(s) and open the R3 table for r3_source = database.
+// The orientation only enters through R3, so the excitons are solved once
+// and every spectrum() / sweep() afterwards costs a χ rotation and a
+// line-shape sum.
+//
+// spectrum(), sweep() and chi2() are const and thread-safe; results go into
+// caller-owned buffers, so a fitting loop can keep one session alive and
+// evaluate it from any number of threads. Errors in the setup (invalid
+// sfg_elements, trajectory input, a missing or malformed PDB or NN map,
+// broken symmetry) throw std::runtime_error.
+// -----------------------------------------------------------------------------
+class SFGSession {
+public:
+    // Rdb: R3 table shared between sessions (r3_source = database); opened
+    // by the session itself if null. report: print the chains, the number
+    // of modes and the cache / symmetry use to stdout (the command line)
+    explicit SFGSession(const InputParams& in,
+                        std::shared_ptr<R3Database> Rdb = nullptr,
+                        bool report = false);
+    explicit SFGSession(const std::string& input_file);   // Read_Input(input_file)
+    ~SFGSession();
+
+    SFGSession(const SFGSession&) = delete;
+    SFGSession& operator=(const SFGSession&) = delete;
+
+    const InputParams&         input()     const { return in_; }
+    const Chi2Plan&            plan()      const { return plan_; }
+    const AmideModeTable&      modes()     const { return modes_; }
+    const std::vector<double>& freq_grid() const { return freq_grid_; }
+
+    int n_modes()    const { return modes_.N; }
+    int n_elements() const { return static_cast<int>(plan_.elements.size()); }
+    int n_freq()     const { return static_cast<int>(freq_grid_.size()); }
+
+    // Exciton solutions: one, or one per disorder realization
+    const std::vector<HamiltonianEquivResult>& excitons() const { return excitons_; }
+
+    // I[e * n_freq() + i]: element e of the plan at freq_grid()[i],
+    // averaged over the disorder ensemble. I holds n_elements() * n_freq().
+    void spectrum(double tilt_deg, double twist_deg, double* I) const;
+
+    // Every (twist, tilt) pair of the grid, twist-major (a = it * nTilt + jt):
+    // I[(a * n_elements() + e) * n_freq() + i]. Orientations run in parallel
+    // (OpenMP).
+    void sweep(const std::vector<double>& tilt_deg,
+               const std::vector<double>& twist_deg,
+               double* I) const;
+
+    // χ of the first exciton solution (all 27 elements with debug_output)
+    Chi2Result chi2(double tilt_deg, double twist_deg) const;
+
+    // Approximate heap size of the mode table, the exciton solutions and
+    // the R3 matrices read so far (bytes)
+    std::size_t memory_bytes() const;
+
+private:
+    void load_structure();
+    void solve_excitons();
+    Chi2Result chi2_of(const HamiltonianEquivResult& H,
+                       double tilt_deg, double twist_deg) const;
+    R3Matrix table_R(double tilt_deg, double twist_deg) const;
+
+    InputParams in_;
+    Chi2Plan plan_;
+    std::vector<double> freq_grid_;
+    AmideModeTable modes_;
+    std::vector<HamiltonianEquivResult> excitons_;
+
+    bool report_;
+
+    // r3_source = database: the HDF5 table, and every matrix read so far by
+    // table index (R3Database::index), so at most one per table entry
+    std::shared_ptr<R3Database> Rdb_;
+    mutable std::mutex R3_mutex_;
+    mutable std::map<std::size_t, std::unique_ptr<R3Matrix>> R3_cache_;
+};
+
+#endif
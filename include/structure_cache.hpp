@@ -0,0 +1,48 @@
+#ifndef STRUCTURE_CACHE_HPP
+#define STRUCTURE_CACHE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "get_amideI_multi.hpp"
+
+// -----------------------------------------------------------------------------
+// Binary cache of the preprocessed structure: the AmideModeTable that
+// Get_AmideI_Multi hands to the Hamiltonian (center, phi/psi, mu, alpha,
+// frequency, anharmonicity), so a rerun with other spectral settings skips
+// the PDB parse and the geometry / frame / property steps.
+//
+// One file per key, <dir>/<16 hex digits>.sfgc. The key is FNV-1a (64 bit)
+// of the PDB bytes and the extraction parameters. The file is a fixed
+// header and one record of doubles per mode, read back through mmap.
+// Files are written to a temporary name and renamed, so parallel runs may
+// share a cache directory.
+// -----------------------------------------------------------------------------
+
+// 0 if the PDB cannot be read
+uint64_t structure_cache_key(
+    const std::string& pdbFile,
+    double center_freq,
+    int helix_a,
+    int helix_b,
+    int layer,
+    const FrequencyMapParams* freq_map
+);
+
+std::string structure_cache_file(const std::string& dir, uint64_t key);
+
+// Fills modes and returns true if file holds the entry for key
+bool load_structure_cache(
+    const std::string& file,
+    uint64_t key,
+    AmideModeTable& modes
+);
+
+// Returns false (with a warning) if the file cannot be written
+bool save_structure_cache(
+    const std::string& file,
+    uint64_t key,
+    const AmideModeTable& modes
+);
+
+#endif
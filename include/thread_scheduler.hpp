@@ -0,0 +1,60 @@
+#ifndef THREAD_SCHEDULER_HPP
+#define THREAD_SCHEDULER_HPP
+
+#include <iosfwd>
+#include <string>
+
+// -----------------------------------------------------------------------------
+// OpenMP / OpenBLAS thread split.
+//
+// n independent eigenproblems of size N can run as n OpenMP workers with
+// single-threaded BLAS (outer), or with fewer workers that each get several
+// OpenBLAS threads (inner). Outer wins for small N, where a threaded dsyev
+// mostly pays synchronization; inner wins for large N, where P concurrent
+// matrices no longer share the caches well. The crossover size is machine
+// dependent: sfg_simulator --tune-threads measures it and stores it in the
+// tuning file, one line per host and thread count. Untuned, DEFAULT_BLAS_CROSSOVER is used.
+//
+// OpenBLAS threads are only changed through BlasThreads scopes. The
+// setting is process-wide, so only the outermost scope applies its count;
+// nested scopes keep it, and thread_plan() returns a serial plan inside
+// one. The daemon and the batch pool run sessions concurrently and hold
+// BlasThreads(1) throughout, so plans only apply to single-session runs.
+// -----------------------------------------------------------------------------
+
+const int DEFAULT_BLAS_CROSSOVER = 256;
+
+struct ThreadPlan {
+    int outer = 1;      // OpenMP workers over the problems
+    int blas  = 1;      // OpenBLAS threads inside each problem
+};
+
+// Split of omp_get_max_threads() cores for n_tasks problems of size N:
+//   N <  crossover: outer = min(P, n_tasks), blas = 1
+//   N >= crossover: blas = 2 at the crossover, doubled per doubling of N
+//                   (at most P); outer = P / blas workers, and if there are
+//                   fewer problems the spare cores go to BLAS
+ThreadPlan thread_plan(int N, int n_tasks);
+
+// Tuned crossover of this machine (0: inner never wins), read on first use
+int blas_crossover();
+
+// $SFG_THREAD_TUNING, else ~/.sfg_thread_tuning
+std::string thread_tuning_file();
+
+// Times P concurrent single-threaded dsyev against P sequential P-thread
+// calls for N = 32 … 1024, stores the first N from which inner is faster
+// (at that size and the next) and returns it (0: never)
+int tune_blas_crossover(std::ostream& log);
+
+// Scoped OpenBLAS thread count (no-op without OpenBLAS)
+class BlasThreads {
+public:
+    explicit BlasThreads(int n);
+    ~BlasThreads();
+
+    BlasThreads(const BlasThreads&) = delete;
+    BlasThreads& operator=(const BlasThreads&) = delete;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef WORK_STEALING_POOL_HPP
+#define WORK_STEALING_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// Work-stealing task pool for the batch driver.
+//
+// Every worker owns a deque. A task submitted from inside a running task
+// goes to the back of its worker's deque and is popped from there (LIFO),
+// so the orientation tasks of a structure run before the worker starts
+// another structure. An idle worker steals from the front of the other
+// deques (the oldest, coarsest tasks). Tasks submitted before run() are dealt out
+// round-robin.
+//
+// Tasks are coarse (a structure setup, a block of orientations), so each
+// deque is a mutex-guarded std::deque rather than a lock-free one.
+// run() returns once every task, including those submitted while running,
+// is done; the first exception thrown by a task is rethrown there.
+// -----------------------------------------------------------------------------
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(int n_workers);
+
+    void submit(Task task);
+    void run();
+
+    int n_workers() const { return static_cast<int>(queues_.size()); }
+
+    // Index of the calling worker, -1 outside run()
+    static int worker_id();
+
+    std::size_t tasks_run() const { return tasks_run_; }
+    std::size_t steals()    const { return steals_; }
+
+private:
+    struct Queue {
+        std::mutex m;
+        std::deque<Task> q;
+    };
+
+    void work(int id);
+    bool pop_local(int id, Task& task);
+    bool steal(int id, Task& task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::size_t next_ = 0;                  // round-robin slot outside run()
+
+    std::atomic<std::size_t> pending_{ 0 }; // submitted, not yet finished
+    std::atomic<std::size_t> tasks_run_{ 0 };
+    std::atomic<std::size_t> steals_{ 0 };
+
+    std::mutex idle_m_;
+    std::condition_variable idle_cv_;
+
+    std::mutex error_m_;
+    std::exception_ptr error_;
+};
+
+#endif
@@ -0,0 +1,489 @@
+// -----------------------------------------------------------------------------
+// Python bindings of libsfg (make python -> python/sfg.so)
+//
+//   import sfg
+//   s = sfg.Session("input/input.txt")      # PDB, mode table, excitons
+//   I = s.spectrum(40.0, 90.0)              # (n_elements, n_freq)
+//   G = s.sweep(tilt, twist)                # (n_twist, n_tilt, n_elements, n_freq)
+//   w = s.eigenvalues()                     # exciton frequencies
+//   c = s.chi2(40.0, 90.0)                  # dict: freq, chi, chi_lab, chi_mol
+//   m = s.modes()                           # dict: x, y, z, mu, alpha, freq, …
+//
+// No array is copied: each one is a buffer-protocol view of C++ memory. The
+// mode table, frequency grid and eigenvalues are owned by the session and
+// read-only; spectra and χ are owned by their result, which the view keeps
+// alive. The views are returned as NumPy arrays (numpy.asarray of the buffer)
+// when NumPy is importable, otherwise as memoryviews. The GIL is released
+// while the session is built and while spectra or χ are computed, so Python
+// threads can evaluate one session concurrently.
+// -----------------------------------------------------------------------------
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "sfg_session.hpp"
+#include "generate_angles.hpp"
+
+
+// -----------------------------------------------------------------------------
+// sfg.Array: strided double buffer over memory kept alive by owner
+// -----------------------------------------------------------------------------
+static const int MAX_DIM = 4;
+
+struct ArrayObject {
+    PyObject_HEAD
+    std::shared_ptr<const void> owner;
+    double* data;
+    int ndim;
+    bool readonly;
+    Py_ssize_t shape[MAX_DIM];
+    Py_ssize_t strides[MAX_DIM];      // bytes
+};
+
+// The types are heap types (PyType_FromSpec): each instance holds a
+// reference to its type, released after the instance itself
+static void Array_dealloc(ArrayObject* self)
+{
+    PyTypeObject* type = Py_TYPE(self);
+    self->owner.~shared_ptr();
+    type->tp_free((PyObject*)self);
+    Py_DECREF(type);
+}
+
+static int Array_getbuffer(ArrayObject* self, Py_buffer* view, int flags)
+{
+    if ((flags & PyBUF_WRITABLE) && self->readonly) {
+        PyErr_SetString(PyExc_BufferError, "sfg.Array: read-only session data");
+        return -1;
+    }
+
+    // C-contiguous unless a stride is not the product of the trailing shape
+    bool contiguous = true;
+    Py_ssize_t step = sizeof(double);
+    for (int d = self->ndim - 1; d >= 0; d--) {
+        if (self->shape[d] > 1 && self->strides[d] != step) contiguous = false;
+        step *= self->shape[d];
+    }
+    if (!contiguous && (flags & PyBUF_STRIDES) != PyBUF_STRIDES) {
+        PyErr_SetString(PyExc_BufferError, "sfg.Array: strided buffer");
+        return -1;
+    }
+
+    Py_ssize_t n = 1;
+    for (int d = 0; d < self->ndim; d++) n *= self->shape[d];
+
+    view->buf        = self->data;
+    view->obj        = (PyObject*)self;
+    view->len        = n * sizeof(double);
+    view->itemsize   = sizeof(double);
+    view->readonly   = self->readonly;
+    view->ndim       = self->ndim;
+    view->format     = (flags & PyBUF_FORMAT) ? (char*)"d" : nullptr;
+    view->shape      = (flags & PyBUF_ND) ? self->shape : nullptr;
+    view->strides    = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? self->strides : nullptr;
+    view->suboffsets = nullptr;
+    view->internal   = nullptr;
+    Py_INCREF(self);
+    return 0;
+}
+
+// Created only by make_array; not callable from Python
+static PyType_Slot Array_slots[] = {
+    { Py_tp_dealloc,   (void*)Array_dealloc },
+    { Py_bf_getbuffer, (void*)Array_getbuffer },
+    { Py_tp_doc,       (void*)"View of a C++ double buffer (buffer protocol)" },
+    { 0, nullptr }
+};
+
+static PyType_Spec Array_spec = {
+    "sfg.Array", sizeof(ArrayObject), 0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_DISALLOW_INSTANTIATION, Array_slots
+};
+
+static PyTypeObject* ArrayType = nullptr;
+
+static PyObject* numpy_asarray = nullptr;   // numpy.asarray, or None
+
+// View of data (shape, element strides) as a NumPy array / memoryview
+static PyObject* make_array(std::shared_ptr<const void> owner, const double* data,
+                            bool readonly, std::initializer_list<Py_ssize_t> shape,
+                            std::initializer_list<Py_ssize_t> strides)
+{
+    ArrayObject* a = PyObject_New(ArrayObject, ArrayType);
+    if (!a) return nullptr;
+
+    new (&a->owner) std::shared_ptr<const void>(std::move(owner));
+    a->data     = const_cast<double*>(data);
+    a->readonly = readonly;
+    a->ndim     = static_cast<int>(shape.size());
+
+    int d = 0;
+    for (Py_ssize_t s : shape)   a->shape[d++] = s;
+    d = 0;
+    for (Py_ssize_t s : strides) a->strides[d++] = s * sizeof(double);
+
+    PyObject* out = (numpy_asarray != Py_None)
+        ? PyObject_CallOneArg(numpy_asarray, (PyObject*)a)
+        : PyMemoryView_FromObject((PyObject*)a);
+    Py_DECREF(a);
+    return out;
+}
+
+// C-contiguous view of a result vector, which the view takes over
+static PyObject* make_array(std::vector<double>&& v, std::initializer_list<Py_ssize_t> shape)
+{
+    std::vector<Py_ssize_t> st(shape.size());
+    Py_ssize_t step = 1;
+    auto s = shape.end();
+    for (size_t d = shape.size(); d-- > 0; ) { st[d] = step; step *= *--s; }
+
+    auto owner = std::make_shared<std::vector<double>>(std::move(v));
+    const double* p = owner->data();
+    switch (shape.size()) {
+    case 1:  return make_array(owner, p, false, shape, { st[0] });
+    case 2:  return make_array(owner, p, false, shape, { st[0], st[1] });
+    case 3:  return make_array(owner, p, false, shape, { st[0], st[1], st[2] });
+    default: return make_array(owner, p, false, shape, { st[0], st[1], st[2], st[3] });
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// sfg.Session
+// -----------------------------------------------------------------------------
+struct SessionObject {
+    PyObject_HEAD
+    std::shared_ptr<const SFGSession> s;
+};
+
+static void Session_dealloc(SessionObject* self)
+{
+    PyTypeObject* type = Py_TYPE(self);     // see Array_dealloc
+    self->s.~shared_ptr();
+    type->tp_free((PyObject*)self);
+    Py_DECREF(type);
+}
+
+static PyObject* Session_new(PyTypeObject* type, PyObject*, PyObject*)
+{
+    SessionObject* self = (SessionObject*)type->tp_alloc(type, 0);
+    if (self) new (&self->s) std::shared_ptr<const SFGSession>();
+    return (PyObject*)self;
+}
+
+// Runs f without the GIL; a C++ exception becomes RuntimeError
+template<typename F>
+static bool run_nogil(F&& f)
+{
+    std::string err;
+    Py_BEGIN_ALLOW_THREADS
+    try { f(); }
+    catch (const std::exception& e) { err = e.what(); if (err.empty()) err = "error"; }
+    Py_END_ALLOW_THREADS
+
+    if (err.empty()) return true;
+    PyErr_SetString(PyExc_RuntimeError, err.c_str());
+    return false;
+}
+
+static int Session_init(SessionObject* self, PyObject* args, PyObject* kwds)
+{
+    static const char* kw[] = { "input_file", nullptr };
+    const char* path;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s", (char**)kw, &path))
+        return -1;
+
+    std::string file = path;
+    std::shared_ptr<const SFGSession> s;
+    if (!run_nogil([&] { s = std::make_shared<const SFGSession>(file); }))
+        return -1;
+    self->s = std::move(s);
+    return 0;
+}
+
+static bool check_session(SessionObject* self)
+{
+    if (self->s) return true;
+    PyErr_SetString(PyExc_RuntimeError, "sfg.Session is not initialized");
+    return false;
+}
+
+static bool to_vector(PyObject* seq, std::vector<double>& v)
+{
+    PyObject* fast = PySequence_Fast(seq, "expected a sequence of angles");
+    if (!fast) return false;
+
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(fast);
+    v.resize(n);
+    for (Py_ssize_t i = 0; i < n; i++) {
+        v[i] = PyFloat_AsDouble(PySequence_Fast_GET_ITEM(fast, i));
+        if (v[i] == -1.0 && PyErr_Occurred()) { Py_DECREF(fast); return false; }
+    }
+    Py_DECREF(fast);
+    return true;
+}
+
+
+static PyObject* Session_spectrum(SessionObject* self, PyObject* args)
+{
+    double tilt, twist;
+    if (!check_session(self) || !PyArg_ParseTuple(args, "dd", &tilt, &twist))
+        return nullptr;
+
+    // own reference: __init__ may replace self->s while the GIL is released
+    std::shared_ptr<const SFGSession> sp = self->s;
+    const SFGSession& s = *sp;
+    std::vector<double> I((size_t)s.n_elements() * s.n_freq());
+    if (!run_nogil([&] { s.spectrum(tilt, twist, I.data()); }))
+        return nullptr;
+
+    return make_array(std::move(I), { s.n_elements(), s.n_freq() });
+}
+
+static PyObject* Session_sweep(SessionObject* self, PyObject* args)
+{
+    PyObject *tilt_obj, *twist_obj;
+    if (!check_session(self) || !PyArg_ParseTuple(args, "OO", &tilt_obj, &twist_obj))
+        return nullptr;
+
+    std::vector<double> tilt, twist;
+    if (!to_vector(tilt_obj, tilt) || !to_vector(twist_obj, twist))
+        return nullptr;
+
+    std::shared_ptr<const SFGSession> sp = self->s;     // see spectrum()
+    const SFGSession& s = *sp;
+    std::vector<double> I(twist.size() * tilt.size() * s.n_elements() * s.n_freq());
+    if (!run_nogil([&] { s.sweep(tilt, twist, I.data()); }))
+        return nullptr;
+
+    return make_array(std::move(I), { (Py_ssize_t)twist.size(), (Py_ssize_t)tilt.size(),
+                                      s.n_elements(), s.n_freq() });
+}
+
+// sweep over the tilt / twist grid of the input file
+static PyObject* Session_sweep_input(SessionObject* self, PyObject*)
+{
+    if (!check_session(self)) return nullptr;
+
+    const InputParams& in = self->s->input();
+    auto tilt  = Linspace(in.tilt_start,  in.tilt_end,  in.tilt_points);
+    auto twist = Linspace(in.twist_start, in.twist_end, in.twist_points);
+
+    PyObject* I = nullptr;
+    PyObject* tl = make_array(std::vector<double>(tilt),  { (Py_ssize_t)tilt.size() });
+    PyObject* tw = make_array(std::vector<double>(twist), { (Py_ssize_t)twist.size() });
+    if (tl && tw) {
+        PyObject* args = PyTuple_Pack(2, tl, tw);
+        if (args) I = Session_sweep(self, args);
+        Py_XDECREF(args);
+    }
+
+    PyObject* out = I ? Py_BuildValue("(NOO)", I, tl, tw) : nullptr;
+    Py_XDECREF(tl);
+    Py_XDECREF(tw);
+    return out;
+}
+
+static PyObject* Session_eigenvalues(SessionObject* self, PyObject* args)
+{
+    int k = 0;
+    if (!check_session(self) || !PyArg_ParseTuple(args, "|i", &k))
+        return nullptr;
+
+    const auto& ex = self->s->excitons();
+    if (k < 0 || k >= (int)ex.size()) {
+        PyErr_SetString(PyExc_IndexError, "exciton solution index out of range");
+        return nullptr;
+    }
+    return make_array(self->s, ex[k].Sort_Ex_Freq.data(), true, { ex[k].N }, { 1 });
+}
+
+// Adds a new reference under key; false (with the error set) if value is null
+static bool set_item(PyObject* dict, const char* key, PyObject* value)
+{
+    if (!value) return false;
+    int rc = PyDict_SetItemString(dict, key, value);
+    Py_DECREF(value);
+    return rc == 0;
+}
+
+static PyObject* Session_chi2(SessionObject* self, PyObject* args)
+{
+    double tilt, twist;
+    if (!check_session(self) || !PyArg_ParseTuple(args, "dd", &tilt, &twist))
+        return nullptr;
+
+    std::shared_ptr<const SFGSession> sp = self->s;     // see spectrum()
+    auto chi = std::make_shared<Chi2Result>();
+    if (!run_nogil([&] { *chi = sp->chi2(tilt, twist); }))
+        return nullptr;
+
+    const Py_ssize_t N = chi->N, nsel = chi->nsel;
+    PyObject* d = PyDict_New();
+    if (!d) return nullptr;
+
+    // chi_lab / chi_mol index i + 3j + 9l -> [k, i, j, l]
+    bool ok = set_item(d, "freq", make_array(chi, chi->freq.data(), false, { N }, { 1 }))
+           && set_item(d, "chi", make_array(chi, chi->chi_sel.data(), false,
+                                            { N, nsel }, { nsel, 1 }));
+    if (ok && !chi->chi_lab.empty())
+        ok = set_item(d, "chi_lab", make_array(chi, chi->chi_lab[0].data(), false,
+                                               { N, 3, 3, 3 }, { 27, 1, 3, 9 }))
+          && set_item(d, "chi_mol", make_array(chi, chi->chi_mol[0].data(), false,
+                                               { N, 3, 3, 3 }, { 27, 1, 3, 9 }));
+    if (!ok) { Py_DECREF(d); return nullptr; }
+    return d;
+}
+
+static PyObject* Session_modes(SessionObject* self, PyObject*)
+{
+    if (!check_session(self)) return nullptr;
+
+    const AmideModeTable& m = self->s->modes();
+    const Py_ssize_t N = m.N;
+    const auto& o = self->s;
+    PyObject* d = PyDict_New();
+    if (!d) return nullptr;
+
+    // alpha is col-major per mode: alpha[i][r][c] = alpha[9i + r + 3c]
+    bool ok = set_item(d, "x",      make_array(o, m.x.data(),      true, { N }, { 1 }))
+           && set_item(d, "y",      make_array(o, m.y.data(),      true, { N }, { 1 }))
+           && set_item(d, "z",      make_array(o, m.z.data(),      true, { N }, { 1 }))
+           && set_item(d, "mu_x",   make_array(o, m.mux.data(),    true, { N }, { 1 }))
+           && set_item(d, "mu_y",   make_array(o, m.muy.data(),    true, { N }, { 1 }))
+           && set_item(d, "mu_z",   make_array(o, m.muz.data(),    true, { N }, { 1 }))
+           && set_item(d, "alpha",  make_array(o, m.alpha.data(),  true, { N, 3, 3 }, { 9, 1, 3 }))
+           && set_item(d, "freq",   make_array(o, m.freq.data(),   true, { N }, { 1 }))
+           && set_item(d, "anharm", make_array(o, m.anharm.data(), true, { N }, { 1 }))
+           && set_item(d, "nn_phi", make_array(o, m.nn_phi.data(), true, { N }, { 1 }))
+           && set_item(d, "nn_psi", make_array(o, m.nn_psi.data(), true, { N }, { 1 }));
+    if (!ok) { Py_DECREF(d); return nullptr; }
+    return d;
+}
+
+static PyObject* Session_freq_grid(SessionObject* self, void*)
+{
+    if (!check_session(self)) return nullptr;
+    const auto& f = self->s->freq_grid();
+    return make_array(self->s, f.data(), true, { (Py_ssize_t)f.size() }, { 1 });
+}
+
+static PyObject* Session_labels(SessionObject* self, void*)
+{
+    if (!check_session(self)) return nullptr;
+    const auto& labels = self->s->plan().labels;
+    PyObject* t = PyTuple_New(labels.size());
+    for (size_t i = 0; t && i < labels.size(); i++)
+        PyTuple_SET_ITEM(t, i, PyUnicode_FromString(labels[i].c_str()));
+    return t;
+}
+
+static PyObject* Session_n_modes(SessionObject* self, void*)
+{
+    return check_session(self) ? PyLong_FromLong(self->s->n_modes()) : nullptr;
+}
+
+static PyObject* Session_n_samples(SessionObject* self, void*)
+{
+    return check_session(self) ? PyLong_FromSize_t(self->s->excitons().size()) : nullptr;
+}
+
+static PyObject* Session_memory_bytes(SessionObject* self, void*)
+{
+    return check_session(self) ? PyLong_FromSize_t(self->s->memory_bytes()) : nullptr;
+}
+
+
+static PyMethodDef Session_methods[] = {
+    { "spectrum", (PyCFunction)Session_spectrum, METH_VARARGS,
+      "spectrum(tilt, twist) -> (n_elements, n_freq) intensities" },
+    { "sweep", (PyCFunction)Session_sweep, METH_VARARGS,
+      "sweep(tilt, twist) -> (n_twist, n_tilt, n_elements, n_freq) intensities" },
+    { "sweep_input", (PyCFunction)Session_sweep_input, METH_NOARGS,
+      "sweep_input() -> (I, tilt, twist) over the angle grid of the input file" },
+    { "eigenvalues", (PyCFunction)Session_eigenvalues, METH_VARARGS,
+      "eigenvalues(k=0) -> exciton frequencies of disorder realization k" },
+    { "chi2", (PyCFunction)Session_chi2, METH_VARARGS,
+      "chi2(tilt, twist) -> dict of freq, chi (N, n_elements) and, with "
+      "debug_output, chi_lab / chi_mol (N, 3, 3, 3)" },
+    { "modes", (PyCFunction)Session_modes, METH_NOARGS,
+      "modes() -> dict of the amide-I mode table (read-only views)" },
+    { nullptr, nullptr, 0, nullptr }
+};
+
+static PyGetSetDef Session_getset[] = {
+    { "freq_grid",    (getter)Session_freq_grid,    nullptr, "spectrum frequencies", nullptr },
+    { "labels",       (getter)Session_labels,       nullptr, "spectrum column names", nullptr },
+    { "n_modes",      (getter)Session_n_modes,      nullptr, "number of amide-I modes", nullptr },
+    { "n_samples",    (getter)Session_n_samples,    nullptr, "exciton solutions (disorder)", nullptr },
+    { "memory_bytes", (getter)Session_memory_bytes, nullptr, "approximate heap size", nullptr },
+    { nullptr, nullptr, nullptr, nullptr, nullptr }
+};
+
+static PyType_Slot Session_slots[] = {
+    { Py_tp_dealloc, (void*)Session_dealloc },
+    { Py_tp_new,     (void*)Session_new },
+    { Py_tp_init,    (void*)Session_init },
+    { Py_tp_methods, (void*)Session_methods },
+    { Py_tp_getset,  (void*)Session_getset },
+    { Py_tp_doc,     (void*)"Session(input_file): one static structure, solved once" },
+    { 0, nullptr }
+};
+
+static PyType_Spec Session_spec = {
+    "sfg.Session", sizeof(SessionObject), 0, Py_TPFLAGS_DEFAULT, Session_slots
+};
+
+
+// -----------------------------------------------------------------------------
+// Module
+// -----------------------------------------------------------------------------
+static PyModuleDef sfg_module = {
+    PyModuleDef_HEAD_INIT,
+    "sfg",
+    "Amide-I SFG spectra (libsfg bindings)",
+    -1,
+    nullptr, nullptr, nullptr, nullptr, nullptr
+};
+
+PyMODINIT_FUNC PyInit_sfg(void)
+{
+    // kept for the life of the process: make_array creates Arrays directly
+    ArrayType = (PyTypeObject*)PyType_FromSpec(&Array_spec);
+    if (!ArrayType) return nullptr;
+    PyObject* SessionType = PyType_FromSpec(&Session_spec);
+    if (!SessionType) return nullptr;
+
+    // NumPy is optional: without it arrays come back as memoryviews
+    PyObject* np = PyImport_ImportModule("numpy");
+    if (np) {
+        numpy_asarray = PyObject_GetAttrString(np, "asarray");
+        Py_DECREF(np);
+    }
+    if (!numpy_asarray) {
+        PyErr_Clear();
+        numpy_asarray = Py_None;
+        Py_INCREF(Py_None);
+    }
+
+    PyObject* m = PyModule_Create(&sfg_module);
+    if (!m) { Py_DECREF(SessionType); return nullptr; }
+
+    Py_INCREF(ArrayType);
+    if (PyModule_AddObject(m, "Session", SessionType) < 0) {
+        Py_DECREF(SessionType);
+        Py_DECREF(ArrayType);
+        Py_DECREF(m);
+        return nullptr;
+    }
+    if (PyModule_AddObject(m, "Array", (PyObject*)ArrayType) < 0) {
+        Py_DECREF(ArrayType);
+        Py_DECREF(m);
+        return nullptr;
+    }
+    return m;
+}
@@ -1,63 +1,104 @@
 #include "Extract_Amide_Coordinates.hpp"
-#include <vector>
+#include "helper_vec3.hpp"
+#include <iostream>
 #include <string>
+#include <vector>
+
+// C–N peptide bond is 1.33 Å; longer than this is a chain break
+static const double MAX_PEPTIDE_BOND = 2.0;
 
-std::vector<AmideIEntry> Extract_Amide_Coordinates(const std::vector<Atom>& atoms)
+// First atom of each backbone name in one residue (-1 if absent)
+struct ResidueAtoms {
+    int N = -1, CA = -1, C = -1, O = -1, OXT = -1;
+};
+
+static std::string residue_label(const Atom& a)
+{
+    std::string s;
+    if (a.chain != ' ') { s += a.chain; s += ':'; }
+    s += a.resName.str() + " " + std::to_string(a.resID);
+    if (a.iCode != ' ') s += a.iCode;
+    return s;
+}
+
+std::vector<AmideIEntry> Extract_Amide_Coordinates(const std::vector<Atom>& atoms, bool report)
 {
     std::vector<AmideIEntry> amides;
 
     int NumAtoms = atoms.size();
 
-    //  Step 1: collect all C atoms in PDB order 
-    std::vector<int> C_indices;
-    C_indices.reserve(NumAtoms);
+    //  Step 1: residue index, one pass over the atoms 
+    std::vector<ResidueAtoms> res;
+    std::vector<int> first;      // first atom of each residue
     for (int i = 0; i < NumAtoms; i++) {
-        if (atoms[i].name == "C") {
-            C_indices.push_back(i);
+        if (i == 0 || residue_key(atoms[i]) != residue_key(atoms[i - 1])) {
+            res.emplace_back();
+            first.push_back(i);
         }
-    }
 
-    //  Step 2: for each C, find the next O 
-    std::vector<int> O_indices(C_indices.size(), -1);
-    for (size_t k = 0; k < C_indices.size(); k++) {
-        int idx = C_indices[k] + 1;
-        while (idx < NumAtoms) {
-            if (atoms[idx].name == "O") {
-                O_indices[k] = idx;
-                break;
-            }
-            idx++;
-        }
+        ResidueAtoms& r = res.back();
+        const PDBName& nm = atoms[i].name;
+        int* slot = nullptr;
+        if      (nm == "N")   slot = &r.N;
+        else if (nm == "CA")  slot = &r.CA;
+        else if (nm == "C")   slot = &r.C;
+        else if (nm == "O")   slot = &r.O;
+        else if (nm == "OXT") slot = &r.OXT;
+        if (slot && *slot < 0) *slot = i;
     }
 
-    // Step 3: from each O, find the next N or OXT 
-    std::vector<int> N_indices(C_indices.size(), -1);
-    for (size_t k = 0; k < C_indices.size(); k++) {
-        int oi = O_indices[k];
-        if (oi < 0) continue;
+    //  Step 2: C/O of residue k with N of residue k+1 (same chain, bonded) 
+    const int nres = res.size();
+    int chain_res = 0, chain_amides = 0;
+
+    for (int k = 0; k < nres; k++) {
+        const ResidueAtoms& r = res[k];
+        const Atom& a0 = atoms[first[k]];
+        const bool has_next = (k + 1 < nres) && atoms[first[k + 1]].chain == a0.chain;
+        const bool next_aa  = has_next && res[k + 1].CA >= 0;
+
+        if (r.CA >= 0) chain_res++;
 
-        int idx = oi + 1;
-        while (idx < NumAtoms) {
-            const std::string &nm = atoms[idx].name;
-            if (nm == "N" || nm == "OXT") {
-                N_indices[k] = idx;
-                break;
+        if (r.C >= 0 && r.O >= 0) {
+            const Atom& C = atoms[r.C];
+            int n = has_next ? res[k + 1].N : -1;
+
+            if (n >= 0) {
+                double d = norm(Vec3{ atoms[n].x - C.x, atoms[n].y - C.y, atoms[n].z - C.z });
+                if (d <= MAX_PEPTIDE_BOND) {
+                    amides.push_back({ C, atoms[r.O], atoms[n] });
+                    chain_amides++;
+                }
+                else if (report) {
+                    std::cerr << "WARNING: chain break between " << residue_label(a0)
+                              << " and " << residue_label(atoms[first[k + 1]])
+                              << " (C-N " << d << " A), no amide-I mode there\n";
+                }
+            }
+            else if (r.OXT >= 0) {
+                // C-terminus: C, O, OXT
+                amides.push_back({ C, atoms[r.O], atoms[r.OXT] });
+                chain_amides++;
+            }
+            else if (report && next_aa) {
+                std::cerr << "WARNING: residue after " << residue_label(a0)
+                          << " has no N, no amide-I mode there\n";
             }
-            idx++;
         }
-    }
-
-    // Step 4: assemble valid C/O/N triplets 
-    for (size_t k = 0; k < C_indices.size(); k++) {
-        if (O_indices[k] < 0 || N_indices[k] < 0) {
-            continue;
+        else if (report && r.CA >= 0 && next_aa) {
+            std::cerr << "WARNING: " << residue_label(a0)
+                      << " has no backbone C/O, no amide-I mode there\n";
         }
 
-        amides.push_back({
-            atoms[C_indices[k]],
-            atoms[O_indices[k]],
-            atoms[N_indices[k]]
-        });
+        // chain summary at its last amino acid (ligands may follow)
+        const bool chain_end = (r.CA >= 0 && !next_aa) || !has_next;
+        if (report && chain_end && chain_res > 0) {
+            std::cout << "Chain " << (a0.chain == ' ' ? '-' : a0.chain) << ": "
+                      << chain_res << " residues, " << chain_amides
+                      << " amide-I modes, ends at " << residue_label(a0)
+                      << (r.OXT >= 0 ? " (OXT)" : "") << "\n";
+        }
+        if (chain_end) { chain_res = 0; chain_amides = 0; }
     }
 
     return amides;
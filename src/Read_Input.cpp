@@ -5,6 +5,7 @@
 #include <unordered_map>
 #include <algorithm>
 #include <cctype>
+#include <stdexcept>
 
 // Trim helper
 static inline std::string trim(const std::string& s) {
@@ -25,15 +26,15 @@ static inline std::string remove_comments(const std::string& line) {
     return line.substr(0, pos);
 }
 
-InputParams Read_Input(const std::string &filename)
+InputParams Read_Input(const std::string &filename,
+                       const std::vector<std::pair<std::string, std::string>> &overrides)
 {
     InputParams p;
     std::unordered_map<std::string, std::string> kv;
 
     std::ifstream fin(filename);
     if(!fin){
-        std::cerr << "ERROR: Cannot open " << filename << "\n";
-        exit(1);
+        throw std::runtime_error(std::string("Cannot open ") + filename);
     }
 
     std::string line;
@@ -56,69 +57,63 @@ InputParams Read_Input(const std::string &filename)
         kv[key] = val;
     }
 
+    for(const auto &o : overrides)
+        kv[o.first] = o.second;
+
     // ---------- Assign required parameters ----------
     if(kv.count("PDB_file"))
         p.pdbFile = kv["PDB_file"];
     else {
-        std::cerr << "ERROR: Missing required input: PDB_file\n";
-        exit(1);
+        throw std::runtime_error("Missing required input: PDB_file");
     }
 
     if(kv.count("center_freq"))
         p.centerFreq = std::stod(kv["center_freq"]);
     else {
-        std::cerr << "ERROR: Missing required input: center_freq\n";
-        exit(1);
+        throw std::runtime_error("Missing required input: center_freq");
     }
 
     if(kv.count("layer"))
         p.layer = std::stoi(kv["layer"]);
     else {
-        std::cerr << "ERROR: Missing required input: layer\n";
-        exit(1);
+        throw std::runtime_error("Missing required input: layer");
     }
 
     if(kv.count("tilt_start"))
         p.tilt_start = std::stod(kv["tilt_start"]);
     else {
-        std::cerr << "ERROR: Missing required input: tilt_start\n";
-        exit(1);
+        throw std::runtime_error("Missing required input: tilt_start");
     }
 
     if(kv.count("tilt_end"))
         p.tilt_end = std::stod(kv["tilt_end"]);
     else {
-        std::cerr << "ERROR: Missing required input: tilt_end\n";
-        exit(1);
+        throw std::runtime_error("Missing required input: tilt_end");
     }
 
     if(kv.count("tilt_points"))
         p.tilt_points = std::stoi(kv["tilt_points"]);
     else {
-        std::cerr << "ERROR: Missing required input: tilt_points\n";
-        exit(1);
+        throw std::runtime_error("Missing required input: tilt_points");
     }
 
     if(kv.count("twist_start"))
         p.twist_start = std::stod(kv["twist_start"]);
     else {
-        std::cerr << "ERROR: Missing required input: twist_start\n";
-        exit(1);
+        throw std::runtime_error("Missing required input: twist_start");
     }
 
     
     if(kv.count("twist_end"))
         p.twist_end= std::stod(kv["twist_end"]);
     else {
-        std::cerr << "ERROR: Missing required input: twist_end\n";
-        exit(1);
+        throw std::runtime_error("Missing required input: twist_end");
     }
 
     if(kv.count("twist_points"))
         p.twist_points = std::stoi(kv["twist_points"]);
     else {
-        std::cerr << "ERROR: Missing required input: twist_points\n";
-        exit(1);
+        throw std::runtime_error("Missing required input: twist_points");
     }
 
     if(kv.count("use_cutoff")) {
@@ -129,8 +124,7 @@ InputParams Read_Input(const std::string &filename)
                 p.cutoff_distance = std::stod(kv["cutoff_distance"]);
             }
             else {
-                std::cerr << "ERROR: Missing required input: cutoff_distance\n";
-                exit(1);
+                throw std::runtime_error("Missing required input: cutoff_distance");
             }
         }
         else if(cutoff == "no") {
@@ -138,122 +132,278 @@ InputParams Read_Input(const std::string &filename)
             p.cutoff_distance = 10000000; // very large dummy variable
         }
         else {
-            std::cerr << "ERROR: Missing or wrong required input: cutoff_distance\n";
-                exit(1);
+            throw std::runtime_error("Missing or wrong required input: cutoff_distance");
         }
 
     }
     else {
-        std::cerr << "ERROR: Missing required input: use_cutoff\n";
-        exit(1);
+        throw std::runtime_error("Missing required input: use_cutoff");
     }
 
     if(kv.count("width"))
         p.width = std::stod(kv["width"]);
     else {
-        std::cerr << "ERROR: Missing required input: width\n";
-        exit(1);
+        throw std::runtime_error("Missing required input: width");
     }
 
     if(kv.count("spec_range_start"))
         p.spec_range_start= std::stod(kv["spec_range_start"]);
     else {
-        std::cerr << "ERROR: Missing required input: spec_range_start\n";
-        exit(1);
+        throw std::runtime_error("Missing required input: spec_range_start");
     }
 
     if(kv.count("spec_range_end"))
         p.spec_range_end = std::stod(kv["spec_range_end"]);
     else {
-        std::cerr << "ERROR: Missing required input: spec_range_end\n";
-        exit(1);
+        throw std::runtime_error("Missing required input: spec_range_end");
     }
 
     if(kv.count("spec_range_step"))
         p.spec_range_step = std::stod(kv["spec_range_step"]);
     else {
-        std::cerr << "ERROR: Missing required input:spec_range_step\n";
-        exit(1);
+        throw std::runtime_error("Missing required input:spec_range_step");
     }
 
     if(kv.count("SpectraFolder"))
         p.SpectraFolder = kv["SpectraFolder"];
     else {
-        std::cerr << "ERROR: Missing required input: SpectraFolder\n";
-        exit(1);
+        throw std::runtime_error("Missing required input: SpectraFolder");
     }
 
     if(kv.count("SpectraStorePrefix"))
         p.SpectraStorePrefix = kv["SpectraStorePrefix"];
     else {
-        std::cerr << "ERROR: Missing required input: SpectraStorePrefix\n";
-        exit(1);
+        throw std::runtime_error("Missing required input: SpectraStorePrefix");
+    }
+
+    // ---------- Optional parameters ----------
+    if(kv.count("amide_range")) {
+        std::istringstream ss(kv["amide_range"]);
+        if(kv["amide_range"] == "all") {
+            p.amide_first = 1;
+            p.amide_last = 0;
+        }
+        else if(!(ss >> p.amide_first >> p.amide_last) ||
+                p.amide_first < 1 || p.amide_last < p.amide_first) {
+            throw std::runtime_error("amide_range must be all or first last (1 <= first <= last)");
+        }
+    }
+
+    if(kv.count("trajectory")) {
+        std::string traj = kv["trajectory"];
+        if(traj == "yes")     p.trajectory = true;
+        else if(traj == "no") p.trajectory = false;
+        else {
+            throw std::runtime_error("trajectory must be yes or no");
+        }
+    }
+
+    if(kv.count("write_frame_spectra")) {
+        std::string wf = kv["write_frame_spectra"];
+        if(wf == "yes")     p.write_frame_spectra = true;
+        else if(wf == "no") p.write_frame_spectra = false;
+        else {
+            throw std::runtime_error("write_frame_spectra must be yes or no");
+        }
+    }
+
+    if(kv.count("disorder_sigma"))
+        p.disorder_sigma = std::stod(kv["disorder_sigma"]);
+
+    if(kv.count("disorder_samples"))
+        p.disorder_samples = std::stoi(kv["disorder_samples"]);
+
+    if(kv.count("disorder_seed"))
+        p.disorder_seed = std::stoul(kv["disorder_seed"]);
+
+    if(kv.count("coupling_model")) {
+        p.coupling_model = kv["coupling_model"];
+        if(p.coupling_model != "tdc" && p.coupling_model != "tdc_nn" &&
+           p.coupling_model != "tdc_periodic") {
+            throw std::runtime_error("coupling_model must be tdc, tdc_nn or tdc_periodic");
+        }
+    }
+
+    if(kv.count("nn_coupling_map"))
+        p.nn_coupling_map = kv["nn_coupling_map"];
+
+    auto read_vec3 = [&](const char* key, Vec3& v) {
+        if(!kv.count(key)) return;
+        std::istringstream ss(kv[key]);
+        if(!(ss >> v.x >> v.y >> v.z)) {
+            throw std::runtime_error(std::string(key) + " needs three numbers (x y z)");
+        }
+    };
+    read_vec3("lattice_a", p.lattice.a);
+    read_vec3("lattice_b", p.lattice.b);
+
+    if(kv.count("lattice_cutoff"))
+        p.lattice.cutoff = std::stod(kv["lattice_cutoff"]);
+
+    if(kv.count("hamiltonian_solver")) {
+        p.hamiltonian_solver = kv["hamiltonian_solver"];
+        if(p.hamiltonian_solver != "dense" && p.hamiltonian_solver != "lanczos") {
+            throw std::runtime_error("hamiltonian_solver must be dense or lanczos");
+        }
+    }
+
+    if(kv.count("lanczos_steps"))
+        p.lanczos_steps = std::stoi(kv["lanczos_steps"]);
+
+    if(kv.count("bh_theta"))
+        p.bh_theta = std::stod(kv["bh_theta"]);
+
+    if(kv.count("r3_source")) {
+        p.r3_source = kv["r3_source"];
+        if(p.r3_source != "analytic" && p.r3_source != "database") {
+            throw std::runtime_error("r3_source must be analytic or database");
+        }
+    }
+
+    if(kv.count("sfg_elements")) {
+        std::istringstream ss(kv["sfg_elements"]);
+        p.sfg_elements.clear();
+        for(std::string e; ss >> e; ) {
+            std::transform(e.begin(), e.end(), e.begin(),
+                           [](unsigned char c) { return std::tolower(c); });
+            p.sfg_elements.push_back(e);
+        }
+    }
+
+    if(kv.count("debug_output")) {
+        std::string dbg = kv["debug_output"];
+        if(dbg == "yes")     p.debug_output = true;
+        else if(dbg == "no") p.debug_output = false;
+        else {
+            throw std::runtime_error("debug_output must be yes or no");
+        }
+    }
+
+    if(kv.count("structure_cache"))
+        p.structure_cache = kv["structure_cache"];
+
+    if(kv.count("symmetry_n"))
+        p.symmetry_n = std::stoi(kv["symmetry_n"]);
+
+    if(kv.count("symmetry_axis") && kv["symmetry_axis"] != "auto")
+        read_vec3("symmetry_axis", p.symmetry_axis);
+
+    if(kv.count("symmetry_tol"))
+        p.symmetry_tol = std::stod(kv["symmetry_tol"]);
+
+    if(kv.count("freq_map")) {
+        std::string fm = kv["freq_map"];
+        if(fm == "field")     p.freq_map = true;
+        else if(fm == "none") p.freq_map = false;
+        else {
+            throw std::runtime_error("freq_map must be none or field");
+        }
+    }
+
+    if(kv.count("freq_map_cutoff"))
+        p.freq_map_params.cutoff = std::stod(kv["freq_map_cutoff"]);
+
+    if(kv.count("freq_map_coef")) {
+        std::istringstream ss(kv["freq_map_coef"]);
+        FrequencyMapParams& fm = p.freq_map_params;
+        if(!(ss >> fm.coef_C >> fm.coef_O >> fm.coef_N)) {
+            throw std::runtime_error("freq_map_coef needs three numbers (C O N)");
+        }
     }
 
     // ---------- Validation ----------
     if(p.centerFreq <= 0) {
-        std::cerr << "ERROR: center_freq must be positive.\n";
-        exit(1);
+        throw std::runtime_error("center_freq must be positive.");
     }
     if(p.layer <= 0) {
-        std::cerr << "ERROR: layer must be positive.\n";
-        exit(1);
+        throw std::runtime_error("layer must be positive.");
     }
     if(p.tilt_start < 0 || p.tilt_start > 180) {
-        std::cerr << "ERROR: tilt_start must in range [0,180].\n";
-        exit(1);
+        throw std::runtime_error("tilt_start must in range [0,180].");
     }
     if(p.tilt_end < p.tilt_start || p.tilt_end > 180) {
-        std::cerr << "ERROR: tilt_end must be [tilt_start,180].\n";
-        exit(1);
+        throw std::runtime_error("tilt_end must be [tilt_start,180].");
     }
     if(p.tilt_points<=0) {
-        std::cerr << "ERROR: tilt_point need to >0 integer.\n";
-        exit(1);
+        throw std::runtime_error("tilt_point need to >0 integer.");
     }
     else {
         if (p.tilt_start == p.tilt_end && p.tilt_points!=1) {
-            std::cerr << "ERROR: tilt_point must be 1 if only 1 angle point is given.\n";
-            exit(1);           
+            throw std::runtime_error("tilt_point must be 1 if only 1 angle point is given.");           
         }
     }
     if(p.twist_start < 0 || p.twist_start > 360) {
-        std::cerr << "ERROR: twist_start must in range [0,360].\n";
-        exit(1);
+        throw std::runtime_error("twist_start must in range [0,360].");
     }
     if(p.twist_end < p.twist_start || p.twist_end > 360) {
-        std::cerr << "ERROR: twist_end must be [twist_start,360].\n";
-        exit(1);
+        throw std::runtime_error("twist_end must be [twist_start,360].");
     }
     if(p.twist_points<=0) {
-        std::cerr << "ERROR: twist_point need to >0 integer.\n";
-        exit(1);
+        throw std::runtime_error("twist_point need to >0 integer.");
     }
     else {
         if (p.twist_start == p.twist_end && p.twist_points!=1) {
-            std::cerr << "ERROR: twist_point must be 1 if only 1 angle point is given.\n";
-            exit(1);           
+            throw std::runtime_error("twist_point must be 1 if only 1 angle point is given.");           
         }
     }
     if(p.cutoff_distance < 5) {
-        std::cerr << "ERROR: cutoff_distance must be greater than or equal to 5.\n";
-        exit(1);
+        throw std::runtime_error("cutoff_distance must be greater than or equal to 5.");
     }
     if(p.width <= 0) {
-        std::cerr << "ERROR: width must be greater than 0.\n";
-        exit(1);
+        throw std::runtime_error("width must be greater than 0.");
     }
     if(p.spec_range_start<=0) {
-        std::cerr << "ERROR: spec_range_start must be greater than 0.\n";
-        exit(1);
+        throw std::runtime_error("spec_range_start must be greater than 0.");
     }
     if(p.spec_range_start>p.spec_range_end) {
-        std::cerr << "ERROR: spec_range_start must be smaller than p.spec_range_end.\n";
-        exit(1);
+        throw std::runtime_error("spec_range_start must be smaller than p.spec_range_end.");
     }
     if(p.spec_range_step<=0) {
-        std::cerr << "ERROR: spec_range_step need to >0.\n";
-        exit(1);
+        throw std::runtime_error("spec_range_step need to >0.");
+    }
+    if(p.disorder_sigma < 0) {
+        throw std::runtime_error("disorder_sigma must be >= 0.");
+    }
+    if(p.coupling_model == "tdc_nn" && p.nn_coupling_map.empty()) {
+        throw std::runtime_error("coupling_model = tdc_nn needs nn_coupling_map.");
+    }
+    if(p.coupling_model == "tdc_periodic") {
+        double area = norm(cross(p.lattice.a, p.lattice.b));
+        if(area < 1e-6) {
+            throw std::runtime_error("coupling_model = tdc_periodic needs non-parallel lattice_a and lattice_b.");
+        }
+        if(p.lattice.cutoff < std::max(norm(p.lattice.a), norm(p.lattice.b))) {
+            throw std::runtime_error("lattice_cutoff must be larger than the lattice vectors.");
+        }
+        if(p.layer != 1) {
+            throw std::runtime_error("coupling_model = tdc_periodic replicates the cell itself, use layer = 1.");
+        }
+    }
+    if(p.hamiltonian_solver == "lanczos") {
+        if(p.coupling_model != "tdc") {
+            throw std::runtime_error("hamiltonian_solver = lanczos supports coupling_model = tdc only.");
+        }
+        if(p.lanczos_steps <= 0 || p.bh_theta < 0) {
+            throw std::runtime_error("lanczos_steps need to >0 and bh_theta >= 0.");
+        }
+    }
+    if(p.symmetry_n <= 0) {
+        throw std::runtime_error("symmetry_n need to >0 integer.");
+    }
+    if(p.symmetry_n > 1 &&
+       (p.trajectory || p.disorder_samples > 1 ||
+        p.hamiltonian_solver != "dense" || p.coupling_model == "tdc_periodic")) {
+        throw std::runtime_error("symmetry_n > 1 needs a static structure: no trajectory, "
+                                 "disorder ensemble, lanczos solver or tdc_periodic.");
+    }
+    if(p.structure_cache != "none" && p.trajectory) {
+        throw std::runtime_error("structure_cache is for a static structure, not a trajectory.");
+    }
+    if(p.freq_map_params.cutoff <= 0) {
+        throw std::runtime_error("freq_map_cutoff must be > 0.");
+    }
+    if(p.disorder_samples <= 0) {
+        throw std::runtime_error("disorder_samples need to >0 integer.");
     }
     return p;
 }
@@ -1,51 +1,102 @@
 #include "Read_PDB_Atoms.hpp"
-#include <fstream>
-#include <iostream>
-#include <algorithm>
+#include "mapped_file.hpp"
+#include <charconv>
+#include <stdexcept>
 
-std::vector<Atom> Read_PDB_Atoms(const std::string &pdbFile)
+
+bool is_backbone_atom(const PDBName& n)
 {
-    std::ifstream fin(pdbFile);
-    if(!fin){
-        std::cerr << "ERROR: Cannot open PDB file: " << pdbFile << "\n";
-        exit(1);
-    }
+    return n == "C" || n == "O" || n == "N" || n == "CA" || n == "OXT";
+}
 
-    std::vector<Atom> atoms;
-    std::string line;
 
-    while(std::getline(fin, line))
-    {
-        if (line.size() < 54) continue;
+// Parse the number in a fixed-width field, ignoring surrounding spaces.
+// Returns false if the field is not a complete number.
+template<typename T>
+static bool parse_field(const char* p, std::size_t n, T& v)
+{
+    const char* b = p;
+    const char* e = p + n;
+    while (b < e && *b == ' ') b++;
+    while (e > b && e[-1] == ' ') e--;
+    if (b == e) return false;
+
+    if (*b == '+') b++;   // from_chars does not take a leading '+'
+    auto r = std::from_chars(b, e, v);
+    return r.ec == std::errc() && r.ptr == e;
+}
 
-        // Accept both ATOM and HETATM
-        if (line.rfind("ATOM", 0) != 0 && line.rfind("HETATM", 0) != 0)
-            continue;
 
-        Atom a;
+static void bad_field(const char* line, std::size_t len, const char* field)
+{
+    throw std::runtime_error(std::string("cannot read ") + field + " from PDB record:\n" +
+                             std::string(line, len));
+}
+
+
+bool Parse_PDB_Atom_Line(const char* line, std::size_t len, Atom &a, bool backbone_only)
+{
+    if (len < 54) return false;
 
-        // ------------------------
-        // PDB atom serial (columns 7–11)
-        // ------------------------
-        std::string serial_str = line.substr(6, 5);
-        serial_str.erase(std::remove(serial_str.begin(), serial_str.end(), ' '), serial_str.end());
-        a.serial = std::stoi(serial_str);
+    // Accept both ATOM and HETATM
+    if (std::strncmp(line, "ATOM", 4) != 0 && std::strncmp(line, "HETATM", 6) != 0)
+        return false;
 
-        // Atom name (columns 12–16)
-        a.name = line.substr(12, 4);
-        a.name.erase(std::remove(a.name.begin(), a.name.end(), ' '), a.name.end());
+    // Atom name (columns 12–16)
+    a.name = PDBName(line + 12, 4);
+    if (backbone_only && !is_backbone_atom(a.name))
+        return false;
 
-        // Residue ID (columns 22–26)
-        std::string resnum = line.substr(22, 4);
-        resnum.erase(std::remove(resnum.begin(), resnum.end(), ' '), resnum.end());
-        a.resID = std::stoi(resnum);
+    // ------------------------
+    // PDB atom serial (columns 7–11); large assemblies overflow it
+    // (***** or hybrid-36), and nothing downstream needs it to be unique
+    // ------------------------
+    if (!parse_field(line + 6, 5, a.serial))
+        a.serial = -1;
 
-        // Coordinates (columns 30–54)
-        a.x = std::stod(line.substr(30, 8));
-        a.y = std::stod(line.substr(38, 8));
-        a.z = std::stod(line.substr(46, 8));
+    // Residue name (columns 18–20)
+    a.resName = PDBName(line + 17, 3);
+
+    // Chain (column 22), residue ID (columns 23–26), insertion code (27)
+    a.chain = line[21];
+    if (!parse_field(line + 22, 4, a.resID))
+        bad_field(line, len, "residue number");
+    a.iCode = line[26];
+
+    // Coordinates (columns 30–54)
+    if (!parse_field(line + 30, 8, a.x) ||
+        !parse_field(line + 38, 8, a.y) ||
+        !parse_field(line + 46, 8, a.z))
+        bad_field(line, len, "coordinates");
+
+    return true;
+}
+
+
+std::vector<Atom> Read_PDB_Atoms(const std::string &pdbFile, bool backbone_only)
+{
+    MappedFile f;
+    if(!f.open(pdbFile))
+        throw std::runtime_error("Cannot open PDB file: " + pdbFile);
+
+    const char* p = f.data();
+    const char* end = p + f.size();
+
+    std::vector<Atom> atoms;
+    atoms.reserve(f.size() / (backbone_only ? 320 : 81));   // ~81 bytes per record
+
+    while(p < end)
+    {
+        const char* nl  = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        const char* eol = nl ? nl : end;
+        std::size_t len = eol - p;
+        if (len > 0 && p[len - 1] == '\r') len--;
+
+        Atom a;
+        if (Parse_PDB_Atom_Line(p, len, a, backbone_only))
+            atoms.push_back(a);
 
-        atoms.push_back(a);
+        p = eol + 1;
     }
 
     return atoms;
@@ -0,0 +1,70 @@
+#include "Read_PDB_Trajectory.hpp"
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+PDBTrajectoryReader::PDBTrajectoryReader(const std::string &pdbFile, bool backbone)
+    : fname(pdbFile), backbone_only(backbone)
+{
+    if (!file.open(pdbFile))
+        throw std::runtime_error("Cannot open PDB trajectory: " + pdbFile);
+}
+
+bool PDBTrajectoryReader::next_frame(std::vector<Atom> &atoms)
+{
+    atoms.clear();
+
+    const char* data = file.data();
+    const std::size_t size = file.size();
+    bool in_model = false;
+
+    auto starts_with = [](const char* p, std::size_t len, const char* tag) {
+        std::size_t n = std::strlen(tag);
+        return len >= n && std::memcmp(p, tag, n) == 0;
+    };
+
+    while (pos < size)
+    {
+        const char* line = data + pos;
+        const char* nl   = static_cast<const char*>(std::memchr(line, '\n', size - pos));
+        std::size_t len  = nl ? (std::size_t)(nl - line) : size - pos;
+        const std::size_t next = pos + len + 1;
+        if (len > 0 && line[len - 1] == '\r') len--;
+
+        if (starts_with(line, len, "MODEL")) {
+            // a MODEL without ENDMDL closes the previous frame
+            if (!atoms.empty()) {
+                std::cerr << "WARNING: " << fname
+                          << ": MODEL without preceding ENDMDL (frame "
+                          << nframes + 1 << ")\n";
+                pos = next;
+                break;
+            }
+            in_model = true;
+            pos = next;
+            continue;
+        }
+
+        pos = next;
+
+        if (starts_with(line, len, "ENDMDL")) {
+            if (in_model || !atoms.empty()) break;
+            continue;
+        }
+
+        // END terminates a single-model file
+        if (starts_with(line, len, "END") && !in_model) {
+            if (!atoms.empty()) break;
+            continue;
+        }
+
+        Atom a;
+        if (Parse_PDB_Atom_Line(line, len, a, backbone_only))
+            atoms.push_back(a);
+    }
+
+    if (atoms.empty()) return false;
+
+    nframes++;
+    return true;
+}
@@ -0,0 +1,131 @@
+#include "amideI_site_kernel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+// Same threshold as normalize(): |v| < 1e-12
+static const double MIN_NORM2    = 1e-24;
+static const double MAX_INV_NORM = 1e12;
+
+// Amides per tile: the unit-stride C / O / N copies of one tile stay in L1
+static const int SITE_TILE = 128;
+
+
+int amideI_site_kernel(const std::vector<AmideIEntry>& amide,
+                       AmideModeTable& modes)
+{
+    const int n = static_cast<int>(amide.size());
+
+    // molecular dipole (MATLAB: 25 deg from -z in the yz plane)
+    const double mu_ang = 25.0 * M_PI / 180.0;
+    const double mu_y =  std::sin(mu_ang);
+    const double mu_z = -std::cos(mu_ang);
+
+    // molecular Raman tensor diag(0.25, 1, 5) rotated by 34 deg about x
+    const double ra = 34.0 * M_PI / 180.0;
+    const double c = std::cos(ra), s = std::sin(ra);
+    const double a_xx = 0.05 * 5;
+    const double a_yy = c * c * (0.20 * 5) + s * s * (1.0 * 5);
+    const double a_zz = s * s * (0.20 * 5) + c * c * (1.0 * 5);
+    const double a_yz = c * s * (0.20 * 5 - 1.0 * 5);
+
+    double Cx[SITE_TILE], Cy[SITE_TILE], Cz[SITE_TILE];
+    double Ox[SITE_TILE], Oy[SITE_TILE], Oz[SITE_TILE];
+    double Nx[SITE_TILE], Ny[SITE_TILE], Nz[SITE_TILE];
+    double Axx[SITE_TILE], Ayy[SITE_TILE], Azz[SITE_TILE];
+    double Axy[SITE_TILE], Axz[SITE_TILE], Ayz[SITE_TILE];
+    double min2[SITE_TILE];     // smallest squared norm of each row's frame
+
+    for (int i0 = 0; i0 < n; i0 += SITE_TILE)
+    {
+        const int m = std::min(SITE_TILE, n - i0);
+
+        // C, O, N of the tile as unit-stride arrays for the vector loop
+        for (int j = 0; j < m; j++) {
+            const AmideIEntry& e = amide[i0 + j];
+            Cx[j] = e.C.x;  Cy[j] = e.C.y;  Cz[j] = e.C.z;
+            Ox[j] = e.O.x;  Oy[j] = e.O.y;  Oz[j] = e.O.z;
+            Nx[j] = e.N.x;  Ny[j] = e.N.y;  Nz[j] = e.N.z;
+        }
+
+        double* x   = modes.x.data()   + i0;
+        double* y   = modes.y.data()   + i0;
+        double* z   = modes.z.data()   + i0;
+        double* mux = modes.mux.data() + i0;
+        double* muy = modes.muy.data() + i0;
+        double* muz = modes.muz.data() + i0;
+        double* alpha = modes.alpha.data() + (size_t)9 * i0;
+
+        // Branch-free and unit-stride, so it vectorizes (sqrtpd needs
+        // -fno-math-errno, see the Makefile). 1/|v| is clamped after the
+        // division: clamping |v| first lets GCC branch around the division.
+        // Degenerate rows are found afterwards from min2, and alpha (9-double
+        // rows) is filled from the tile arrays below.
+        #pragma omp simd
+        for (int j = 0; j < m; j++)
+        {
+            // Z = unit C=O, and unit C-N
+            double zx = Ox[j] - Cx[j], zy = Oy[j] - Cy[j], zz = Oz[j] - Cz[j];
+            double bx = Nx[j] - Cx[j], by = Ny[j] - Cy[j], bz = Nz[j] - Cz[j];
+
+            double z2 = zx * zx + zy * zy + zz * zz;
+            double b2 = bx * bx + by * by + bz * bz;
+
+            double iz = std::min(1.0 / std::sqrt(z2), MAX_INV_NORM);
+            double ib = std::min(1.0 / std::sqrt(b2), MAX_INV_NORM);
+            zx *= iz;  zy *= iz;  zz *= iz;
+            bx *= ib;  by *= ib;  bz *= ib;
+
+            // vibration centre = C + 0.665 CO + 0.256 CN
+            x[j] = Cx[j] + zx * 0.665 + bx * 0.256;
+            y[j] = Cy[j] + zy * 0.665 + by * 0.256;
+            z[j] = Cz[j] + zz * 0.665 + bz * 0.256;
+
+            // X = unit (Z × CN), Y = X × Z
+            double xx = zy * bz - zz * by;
+            double xy = zz * bx - zx * bz;
+            double xz = zx * by - zy * bx;
+            double x2 = xx * xx + xy * xy + xz * xz;
+            min2[j] = std::min(std::min(z2, b2), x2);
+
+            double ix = std::min(1.0 / std::sqrt(x2), MAX_INV_NORM);
+            xx *= ix;  xy *= ix;  xz *= ix;
+
+            double yx = xy * zz - xz * zy;
+            double yy = xz * zx - xx * zz;
+            double yz = xx * zy - xy * zx;
+
+            // μ = T μ_mol (μ_mol has no x component)
+            mux[j] = yx * mu_y + zx * mu_z;
+            muy[j] = yy * mu_y + zy * mu_z;
+            muz[j] = yz * mu_y + zz * mu_z;
+
+            // α = T A T', symmetric, stored col-major
+            auto t = [&](double Xr, double Yr, double Zr, double Xq, double Yq, double Zq) {
+                return a_xx * Xr * Xq + a_yy * Yr * Yq + a_zz * Zr * Zq
+                     + a_yz * (Yr * Zq + Zr * Yq);
+            };
+            Axx[j] = t(xx, yx, zx, xx, yx, zx);
+            Ayy[j] = t(xy, yy, zy, xy, yy, zy);
+            Azz[j] = t(xz, yz, zz, xz, yz, zz);
+            Axy[j] = t(xx, yx, zx, xy, yy, zy);
+            Axz[j] = t(xx, yx, zx, xz, yz, zz);
+            Ayz[j] = t(xy, yy, zy, xz, yz, zz);
+        }
+
+        for (int j = 0; j < m; j++) {
+            double* a = alpha + (size_t)9 * j;
+            a[0] = Axx[j];  a[3] = Axy[j];  a[6] = Axz[j];
+            a[1] = Axy[j];  a[4] = Ayy[j];  a[7] = Ayz[j];
+            a[2] = Axz[j];  a[5] = Ayz[j];  a[8] = Azz[j];
+        }
+
+        const double* bad = std::find_if(min2, min2 + m,
+                                         [](double v) { return v < MIN_NORM2; });
+        if (bad != min2 + m)
+            return i0 + static_cast<int>(bad - min2);
+    }
+
+    return -1;
+}
@@ -1,4 +1,7 @@
 #include "apply_R3.hpp"
+#include <cblas.h>
+#include <cmath>
+#include <vector>
 
 std::array<double,27> apply_R3_single(
     const R3Matrix& R,
@@ -17,3 +20,210 @@ std::array<double,27> apply_R3_single(
 
     return chi_out;
 }
+
+
+R3Rotation make_R3_rotation(double psi_deg, double theta_deg)
+{
+    const double psi = psi_deg * M_PI / 180.0;
+    const double th  = theta_deg * M_PI / 180.0;
+    const double cp = std::cos(psi), sp = std::sin(psi);
+    const double ct = std::cos(th),  st = std::sin(th);
+
+    // Rx(theta) * Rz(psi)
+    R3Rotation r = {{
+        { cp,       -sp,       0.0 },
+        { ct * sp,   ct * cp, -st  },
+        { st * sp,   st * cp,  ct  }
+    }};
+    return r;
+}
+
+
+std::array<double,27> apply_R3_rotation(
+    const R3Rotation& Rot,
+    const std::array<double,9>& alpha,
+    const Vec3& mu)
+{
+    const double (&R)[3][3] = Rot.R;
+
+    // μ' = R μ
+    double m[3];
+    for (int i = 0; i < 3; i++)
+        m[i] = R[i][0] * mu.x + R[i][1] * mu.y + R[i][2] * mu.z;
+
+    // α' = R α R^T   (α(i,j) = alpha[i + 3j])
+    double t[3][3], a[3][3];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            t[i][j] = R[i][0] * alpha[0 + 3 * j]
+                    + R[i][1] * alpha[1 + 3 * j]
+                    + R[i][2] * alpha[2 + 3 * j];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            a[i][j] = t[i][0] * R[j][0] + t[i][1] * R[j][1] + t[i][2] * R[j][2];
+
+    // average over the azimuth: components invariant about z
+    enum { X = 0, Y = 1, Z = 2 };
+    auto T = [&](int i, int j, int l) { return a[i][j] * m[l]; };
+
+    const double zzz = T(Z, Z, Z);
+    const double xxz = 0.5 * (T(X, X, Z) + T(Y, Y, Z));
+    const double xzx = 0.5 * (T(X, Z, X) + T(Y, Z, Y));
+    const double zxx = 0.5 * (T(Z, X, X) + T(Z, Y, Y));
+    const double xyz = 0.5 * (T(X, Y, Z) - T(Y, X, Z));
+    const double xzy = 0.5 * (T(X, Z, Y) - T(Y, Z, X));
+    const double zxy = 0.5 * (T(Z, X, Y) - T(Z, Y, X));
+
+    std::array<double,27> out{};
+    auto at = [&](int i, int j, int l) -> double& { return out[i + 3 * j + 9 * l]; };
+
+    at(Z, Z, Z) = zzz;
+    at(X, X, Z) = xxz;  at(Y, Y, Z) =  xxz;
+    at(X, Z, X) = xzx;  at(Y, Z, Y) =  xzx;
+    at(Z, X, X) = zxx;  at(Z, Y, Y) =  zxx;
+    at(X, Y, Z) = xyz;  at(Y, X, Z) = -xyz;
+    at(X, Z, Y) = xzy;  at(Y, Z, X) = -xzy;
+    at(Z, X, Y) = zxy;  at(Z, Y, X) = -zxy;
+
+    return out;
+}
+
+
+void apply_R3_rotation_elements(
+    const R3Rotation& Rot,
+    const std::array<double,9>& alpha,
+    const Vec3& mu,
+    const int* idx,
+    int n,
+    double* out)
+{
+    const double (&R)[3][3] = Rot.R;
+
+    double m[3];
+    for (int i = 0; i < 3; i++)
+        m[i] = R[i][0] * mu.x + R[i][1] * mu.y + R[i][2] * mu.z;
+
+    // α'(i,j) on demand
+    auto a = [&](int i, int j) {
+        double s = 0.0;
+        for (int p = 0; p < 3; p++)
+            s += R[i][p] * (alpha[p + 0] * R[j][0] + alpha[p + 3] * R[j][1] + alpha[p + 6] * R[j][2]);
+        return s;
+    };
+
+    enum { X = 0, Y = 1, Z = 2 };
+
+    for (int e = 0; e < n; e++)
+    {
+        int c[3] = { idx[e] % 3, (idx[e] / 3) % 3, idx[e] / 9 };
+        int nz = (c[0] == Z) + (c[1] == Z) + (c[2] == Z);
+
+        if (nz == 3) { out[e] = a(Z, Z) * m[Z]; continue; }
+        if (nz != 1) { out[e] = 0.0; continue; }   // not invariant about z
+
+        // the two in-plane slots u < v: equal indices give the xx + yy
+        // average, different ones ±(xy - yx) / 2
+        int u = (c[0] == Z) ? 1 : 0;
+        int v = (c[2] == Z) ? 1 : 2;
+        auto T = [&](int cu, int cv) {
+            int t[3] = { c[0], c[1], c[2] };
+            t[u] = cu;  t[v] = cv;
+            return a(t[0], t[1]) * m[t[2]];
+        };
+
+        if (c[u] == c[v])     out[e] = 0.5 * (T(X, X) + T(Y, Y));
+        else if (c[u] == X)   out[e] = 0.5 * (T(X, Y) - T(Y, X));
+        else                  out[e] = -0.5 * (T(X, Y) - T(Y, X));
+    }
+}
+
+
+// -----------------------------------------------------------------------------
+// Sparse R3
+// -----------------------------------------------------------------------------
+
+// chi_lab index of each distinct row (zzz, xxz, xzx, zxx, xyz, xzy, zxy)
+static const int R3_SPARSE_REP[R3_SPARSE_NROW] = { 26, 18, 6, 2, 21, 15, 11 };
+
+
+R3Sparse make_R3_sparse(const R3Rotation& Rot)
+{
+    const double (&R)[3][3] = Rot.R;
+    enum { X = 0, Y = 1, Z = 2 };
+
+    // row of (R' ⊗ 3) for lab element (i, j, l), scaled by w and added
+    R3Sparse S{};
+    auto add = [&](int r, double w, int i, int j, int l) {
+        for (int s = 0; s < 3; s++)
+            for (int q = 0; q < 3; q++)
+                for (int p = 0; p < 3; p++)
+                    S.row[r][p + 3 * q + 9 * s] += w * R[i][p] * R[j][q] * R[l][s];
+    };
+
+    add(0, 1.0, Z, Z, Z);
+    add(1, 0.5, X, X, Z);  add(1,  0.5, Y, Y, Z);
+    add(2, 0.5, X, Z, X);  add(2,  0.5, Y, Z, Y);
+    add(3, 0.5, Z, X, X);  add(3,  0.5, Z, Y, Y);
+    add(4, 0.5, X, Y, Z);  add(4, -0.5, Y, X, Z);
+    add(5, 0.5, X, Z, Y);  add(5, -0.5, Y, Z, X);
+    add(6, 0.5, Z, X, Y);  add(6, -0.5, Z, Y, X);
+
+    return S;
+}
+
+
+R3Sparse make_R3_sparse(const R3Matrix& R)
+{
+    R3Sparse S;
+    for (int r = 0; r < R3_SPARSE_NROW; r++)
+        for (int j = 0; j < 27; j++)
+            S.row[r][j] = R.m[R3_SPARSE_REP[r]][j];
+    return S;
+}
+
+
+std::array<double,27> apply_R3_sparse(
+    const R3Sparse& R,
+    const std::array<double,27>& chi_in)
+{
+    double v[R3_SPARSE_NROW];
+    for (int r = 0; r < R3_SPARSE_NROW; r++)
+    {
+        double sum = 0.0;
+        for (int j = 0; j < 27; j++)
+            sum += R.row[r][j] * chi_in[j];
+        v[r] = sum;
+    }
+
+    std::array<double,27> chi_out{};
+    for (int i = 0; i < 27; i++)
+        if (R3_SPARSE_ROW[i] >= 0)
+            chi_out[i] = R3_SPARSE_SIGN[i] * v[R3_SPARSE_ROW[i]];
+
+    return chi_out;
+}
+
+
+void apply_R3_sparse_batch(
+    const R3Sparse& R,
+    const double* chi_in,
+    double* chi_out,
+    int n)
+{
+    if (n <= 0) return;
+
+    // V (n×7) = chi_in (n×27) · rows'
+    std::vector<double> V((size_t)n * R3_SPARSE_NROW);
+    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasTrans,
+                n, R3_SPARSE_NROW, 27,
+                1.0, chi_in, 27, &R.row[0][0], 27,
+                0.0, V.data(), R3_SPARSE_NROW);
+
+    for (int k = 0; k < n; k++)
+    {
+        const double* v = &V[(size_t)k * R3_SPARSE_NROW];
+        double* out = chi_out + (size_t)k * 27;
+        for (int i = 0; i < 27; i++)
+            out[i] = (R3_SPARSE_ROW[i] >= 0) ? R3_SPARSE_SIGN[i] * v[R3_SPARSE_ROW[i]] : 0.0;
+    }
+}
@@ -0,0 +1,329 @@
+#include "batch_driver.hpp"
+#include "work_stealing_pool.hpp"
+#include "sfg_session.hpp"
+#include "load_R3ZXZ1.hpp"
+#include "generate_angles.hpp"
+#include "thread_scheduler.hpp"
+
+#include <omp.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+
+// -----------------------------------------------------------------------------
+// Manifest
+// -----------------------------------------------------------------------------
+
+// Whitespace-separated words; double quotes group (and are removed)
+static std::vector<std::string> split_words(const std::string& line, int lineno)
+{
+    std::vector<std::string> words;
+    std::string w;
+    bool quoted = false, have = false;
+
+    for (char c : line) {
+        if (c == '"') { quoted = !quoted; have = true; continue; }
+        if (!quoted && (c == ' ' || c == '\t' || c == '\r')) {
+            if (have) words.push_back(w);
+            w.clear();
+            have = false;
+            continue;
+        }
+        w += c;
+        have = true;
+    }
+    if (quoted)
+        throw std::runtime_error("manifest line " + std::to_string(lineno) +
+                                 ": unterminated quote");
+    if (have) words.push_back(w);
+    return words;
+}
+
+std::vector<BatchJob> read_batch_manifest(const std::string& manifest)
+{
+    std::ifstream fin(manifest);
+    if (!fin)
+        throw std::runtime_error("Cannot open batch manifest " + manifest);
+
+    std::vector<BatchJob> jobs;
+    std::string line;
+    for (int lineno = 1; std::getline(fin, line); lineno++)
+    {
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+
+        auto words = split_words(line, lineno);
+        if (words.empty()) continue;
+
+        BatchJob job;
+        job.input_file = words[0];
+        job.line = lineno;
+        for (size_t k = 1; k < words.size(); k++) {
+            size_t eq = words[k].find('=');
+            if (eq == std::string::npos || eq == 0)
+                throw std::runtime_error("manifest line " + std::to_string(lineno) +
+                                         ": expected key=value, got '" + words[k] + "'");
+            job.overrides.emplace_back(words[k].substr(0, eq), words[k].substr(eq + 1));
+        }
+        jobs.push_back(std::move(job));
+    }
+    return jobs;
+}
+
+InputParams read_batch_job(const BatchJob& job)
+{
+    InputParams in = Read_Input(job.input_file, job.overrides);
+
+    bool pdb_set = false, prefix_set = false;
+    for (const auto& o : job.overrides) {
+        pdb_set    |= o.first == "PDB_file";
+        prefix_set |= o.first == "SpectraStorePrefix";
+    }
+    if (pdb_set && !prefix_set)
+        in.SpectraStorePrefix += "_" + std::filesystem::path(in.pdbFile).stem().string();
+
+    if (in.trajectory)
+        throw std::runtime_error("trajectory input is not supported in batch mode "
+                                 "(list the frames as separate PDB files)");
+    return in;
+}
+
+
+// -----------------------------------------------------------------------------
+// Jobs
+// -----------------------------------------------------------------------------
+namespace {
+
+struct Batch {
+    WorkStealingPool pool;
+    std::shared_ptr<R3Database> Rdb;
+    std::once_flag Rdb_once;
+
+    std::mutex log_m;
+    std::atomic<int> failed{ 0 };
+    std::atomic<int> done{ 0 };
+    int n_jobs = 0;
+
+    explicit Batch(int n_threads) : pool(n_threads) {}
+
+    void log(const std::string& msg)
+    {
+        std::lock_guard<std::mutex> lock(log_m);
+        std::cout << msg << "\n";
+    }
+
+    void fail(const BatchJob& job, const std::string& msg)
+    {
+        failed++;
+        std::lock_guard<std::mutex> lock(log_m);
+        std::cerr << "ERROR: manifest line " << job.line << " (" << job.input_file
+                  << "): " << msg << "\n";
+    }
+
+    // HDF5 errors are not std::exceptions; they fail the job like any other
+    std::shared_ptr<R3Database> r3_table()
+    {
+        std::call_once(Rdb_once, [&] {
+            try {
+                Rdb = std::make_shared<R3Database>("./data/R3ZXZ1_database.h5");
+            } catch (const H5::Exception& e) {
+                throw std::runtime_error("Cannot open R3 table ./data/R3ZXZ1_database.h5: " +
+                                         e.getDetailMsg());
+            }
+        });
+        return Rdb;
+    }
+};
+
+// One structure, set up by its structure task and shared by its
+// orientation blocks; the session is released with the last block
+struct StructureRun {
+    const BatchJob* job;
+    InputParams in;
+    std::shared_ptr<const SFGSession> session;
+    std::vector<double> tilt, twist;
+    std::string header;
+    std::atomic<int> blocks_left{ 0 };
+    std::atomic<bool> failed{ false };   // set by the first failing block
+};
+
+// OpenMP inside a task (disorder batch, sweep) runs on one thread: the pool
+// already keeps every core busy. The setting is per thread.
+static void single_threaded_omp()
+{
+    if (omp_get_max_threads() != 1) omp_set_num_threads(1);
+}
+
+static void write_spectrum(const StructureRun& run, int a, const double* Ia)
+{
+    const SFGSession& s = *run.session;
+    const int nTilt  = run.tilt.size();
+    const int nsel   = s.n_elements();
+    const size_t nf  = s.n_freq();
+
+    std::string tag =
+        "tilt" + std::to_string((int)std::round(run.tilt[a % nTilt])) +
+        "_twist" + std::to_string((int)std::round(run.twist[a / nTilt]));
+    std::string fname =
+        run.in.SpectraFolder + "/" + run.in.SpectraStorePrefix + "_" + tag + ".txt";
+
+    std::ofstream fout(fname);
+    if (!fout)
+        throw std::runtime_error("Cannot write " + fname);
+
+    fout << run.header << "\n";
+    fout << std::setprecision(10);
+    for (size_t i = 0; i < nf; i++) {
+        fout << s.freq_grid()[i];
+        for (int e = 0; e < nsel; e++)
+            fout << " " << Ia[e * nf + i];
+        fout << "\n";
+    }
+}
+
+static void orientation_block(Batch& B, std::shared_ptr<StructureRun> run, int a0, int a1)
+{
+    single_threaded_omp();
+
+    const SFGSession& s = *run->session;
+    const int nTilt = run->tilt.size();
+    std::vector<double> I((size_t)s.n_elements() * s.n_freq());
+
+    // the structure fails once, whichever of its blocks fail; the other
+    // structures of the batch go on
+    std::string err;
+    try {
+        for (int a = a0; a < a1 && !run->failed; a++) {
+            s.spectrum(run->tilt[a % nTilt], run->twist[a / nTilt], I.data());
+            write_spectrum(*run, a, I.data());
+        }
+    } catch (const std::exception& e) {
+        err = e.what();
+    } catch (const H5::Exception& e) {
+        // R3 table read (r3_source = database); not a std::exception
+        err = "Cannot read R3 table ./data/R3ZXZ1_database.h5: " + e.getDetailMsg();
+    }
+    if (!err.empty() && !run->failed.exchange(true))
+        B.fail(*run->job, err);
+
+    if (--run->blocks_left == 0) {
+        if (!run->failed)
+            B.log("Done " + std::to_string(++B.done) + "/" + std::to_string(B.n_jobs) + ": " +
+                  run->in.SpectraFolder + "/" + run->in.SpectraStorePrefix + " (" +
+                  std::to_string(s.n_modes()) + " modes)");
+        run->session.reset();
+    }
+}
+
+// Structure task: session, then the orientation grid as blocks on this
+// worker's deque (run here first, stolen by idle workers)
+static void structure_task(Batch& B, std::shared_ptr<StructureRun> run)
+{
+    single_threaded_omp();
+
+    try {
+        std::shared_ptr<R3Database> Rdb;
+        if (run->in.r3_source == "database") Rdb = B.r3_table();
+        run->session = std::make_shared<const SFGSession>(run->in, Rdb);
+    } catch (const std::exception& e) {
+        B.fail(*run->job, e.what());
+        return;
+    }
+
+    std::filesystem::create_directories(run->in.SpectraFolder);
+    run->header = "# freq";
+    for (const auto& l : run->session->plan().labels) run->header += "   " + l;
+
+    // about four blocks per worker, so a large grid spreads over the node
+    const int nAng  = run->tilt.size() * run->twist.size();
+    const int block = std::max(1, nAng / (4 * B.pool.n_workers()));
+    const int nblk  = (nAng + block - 1) / block;
+
+    if (nblk == 0) { run->session.reset(); return; }
+    run->blocks_left = nblk;
+    for (int a0 = 0; a0 < nAng; a0 += block) {
+        int a1 = std::min(nAng, a0 + block);
+        B.pool.submit([&B, run, a0, a1] { orientation_block(B, run, a0, a1); });
+    }
+}
+
+} // namespace
+
+
+int run_batch(const std::string& manifest, int n_threads)
+{
+    std::vector<BatchJob> jobs;
+    try {
+        jobs = read_batch_manifest(manifest);
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << "\n";
+        return 1;
+    }
+
+    Batch B(n_threads);
+    B.n_jobs = jobs.size();
+    std::cout << "Batch: " << jobs.size() << " jobs from " << manifest
+              << ", " << B.pool.n_workers() << " workers\n";
+
+    // Inputs first, so conflicting outputs are found before any work
+    std::map<std::string, int> outputs;
+    bool debug_ignored = false;
+
+    for (const auto& job : jobs)
+    {
+        auto run = std::make_shared<StructureRun>();
+        run->job = &job;
+        try {
+            run->in = read_batch_job(job);
+        } catch (const std::exception& e) {
+            B.fail(job, e.what());
+            continue;
+        }
+        InputParams& in = run->in;
+
+        std::string out = (std::filesystem::path(in.SpectraFolder) /
+                           in.SpectraStorePrefix).lexically_normal().string();
+        auto ins = outputs.emplace(out, job.line);
+        if (!ins.second) {
+            B.fail(job, "output " + out + " already used by manifest line " +
+                        std::to_string(ins.first->second));
+            continue;
+        }
+
+        debug_ignored |= in.debug_output;
+        in.debug_output = false;
+
+        run->tilt  = Linspace(in.tilt_start,  in.tilt_end,  in.tilt_points);
+        run->twist = Linspace(in.twist_start, in.twist_end, in.twist_points);
+        B.pool.submit([&B, run] { structure_task(B, run); });
+    }
+
+    if (debug_ignored)
+        std::cout << "Batch: debug_output is ignored in batch mode\n";
+
+    // the calling thread is a worker too; restore its OpenMP setting after.
+    // Workers run concurrently, so OpenBLAS stays single-threaded.
+    const int omp_threads = omp_get_max_threads();
+    omp_set_num_threads(1);
+    try {
+        BlasThreads blas(1);
+        B.pool.run();
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << "\n";
+        B.failed++;
+    }
+    omp_set_num_threads(omp_threads);
+
+    std::cout << "Batch: " << B.done << " done, " << B.failed << " failed, "
+              << B.pool.tasks_run() << " tasks, " << B.pool.steals() << " steals\n";
+    return B.failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,118 @@
+#include "batched_eigensolver.hpp"
+#include <algorithm>
+#include <cmath>
+
+
+int batched_syev_jacobi(
+    int N,
+    int batch,
+    std::vector<double>& A,
+    std::vector<double>& evals,
+    double tol,
+    int max_sweeps)
+{
+    const int B = batch;
+    const size_t NB = (size_t)N * B;
+
+    auto at = [&](int i, int j) -> double* { return &A[((size_t)i * N + j) * B]; };
+
+    // eigenvector accumulator V = I
+    std::vector<double> V((size_t)N * NB, 0.0);
+    for (int i = 0; i < N; i++)
+        std::fill_n(&V[((size_t)i * N + i) * B], B, 1.0);
+
+    // convergence is judged relative to each matrix's own scale
+    std::vector<double> scale(B, 0.0);
+    for (int i = 0; i < N; i++)
+        for (int j = 0; j < N; j++) {
+            const double* a = at(i, j);
+            for (int b = 0; b < B; b++) scale[b] = std::max(scale[b], std::fabs(a[b]));
+        }
+
+    std::vector<double> c(B), s(B), t(B);
+
+    int sweep = 0;
+    for (; sweep < max_sweeps; sweep++)
+    {
+        // largest relative off-diagonal element over the batch
+        double off = 0.0;
+        for (int p = 0; p < N; p++)
+            for (int q = p + 1; q < N; q++) {
+                const double* a = at(p, q);
+                for (int b = 0; b < B; b++)
+                    off = std::max(off, std::fabs(a[b]) / (scale[b] + 1e-300));
+            }
+        if (off <= tol) break;
+
+        for (int p = 0; p < N; p++)
+        {
+            for (int q = p + 1; q < N; q++)
+            {
+                double* apq = at(p, q);
+                double* app = at(p, p);
+                double* aqq = at(q, q);
+
+                // rotation zeroing A(p,q) in every matrix
+                #pragma omp simd
+                for (int b = 0; b < B; b++) {
+                    double a   = apq[b];
+                    bool   big = std::fabs(a) > tol * scale[b];
+                    double aa  = big ? a : 1.0;           // avoid 0/0
+                    double th  = (aqq[b] - app[b]) / (2.0 * aa);
+                    double tt  = (th >= 0.0 ? 1.0 : -1.0) /
+                                 (std::fabs(th) + std::sqrt(th * th + 1.0));
+                    tt   = big ? tt : 0.0;
+                    t[b] = tt;
+                    c[b] = 1.0 / std::sqrt(tt * tt + 1.0);
+                    s[b] = tt * c[b];
+                }
+
+                // diagonal pair and the zeroed element
+                #pragma omp simd
+                for (int b = 0; b < B; b++) {
+                    double a = apq[b];
+                    app[b] -= t[b] * a;
+                    aqq[b] += t[b] * a;
+                    apq[b]  = 0.0;
+                }
+
+                // remaining rows/columns r != p,q; only the upper triangle
+                // is kept up to date, the lower one is never read
+                for (int r = 0; r < N; r++)
+                {
+                    if (r == p || r == q) continue;
+                    double* arp = (r < p) ? at(r, p) : at(p, r);
+                    double* arq = (r < q) ? at(r, q) : at(q, r);
+
+                    #pragma omp simd
+                    for (int b = 0; b < B; b++) {
+                        double x = arp[b], y = arq[b];
+                        arp[b] = c[b] * x - s[b] * y;
+                        arq[b] = s[b] * x + c[b] * y;
+                    }
+                }
+
+                // V <- V J
+                for (int r = 0; r < N; r++)
+                {
+                    double* vrp = &V[((size_t)r * N + p) * B];
+                    double* vrq = &V[((size_t)r * N + q) * B];
+
+                    #pragma omp simd
+                    for (int b = 0; b < B; b++) {
+                        double x = vrp[b], y = vrq[b];
+                        vrp[b] = c[b] * x - s[b] * y;
+                        vrq[b] = s[b] * x + c[b] * y;
+                    }
+                }
+            }
+        }
+    }
+
+    evals.resize(NB);
+    for (int k = 0; k < N; k++)
+        std::copy_n(at(k, k), B, &evals[(size_t)k * B]);
+
+    A.swap(V);
+    return sweep;
+}
@@ -1,5 +1,6 @@
 #include "chi2_matlab.hpp"
 #include "apply_R3.hpp"
+#include <cctype>
 #include <iostream>
 #include <iomanip>
 
@@ -32,11 +33,61 @@ static std::array<double,27> outer_alpha_mu(
 
 
 // -----------------------------------------------------------------------------
-// MATLAB-equivalent χ² computation
+// Polarization plan
 // -----------------------------------------------------------------------------
-Chi2Result compute_chi2_matlab(
-    const HamiltonianEquivResult& H,
-    const R3Matrix& R)
+bool make_chi2_plan(const std::vector<std::string>& requested, bool full, Chi2Plan& plan)
+{
+    // SFG, vis, IR polarizations -> tensor element (p = z, no Fresnel factors)
+    static const char* const POL[][2] = {
+        { "ssp", "yyz" }, { "sps", "yzy" }, { "pss", "zyy" }, { "ppp", "zzz" }
+    };
+
+    plan = Chi2Plan();
+    plan.full = full;
+
+    for (const std::string& r : requested)
+    {
+        std::string elem = r, label = r;
+        for (const auto& pol : POL)
+            if (r == pol[0]) {
+                elem = pol[1];
+                label = r;
+                for (char& ch : label) ch = (char)std::toupper(ch);
+                label += "(" + elem + ")";
+            }
+
+        int idx = 0, stride = 1;
+        bool ok = (elem.size() == 3);
+        for (size_t c = 0; ok && c < 3; c++) {
+            if (elem[c] < 'x' || elem[c] > 'z') ok = false;
+            else idx += (elem[c] - 'x') * stride;
+            stride *= 3;
+        }
+        if (!ok) {
+            std::cerr << "ERROR: unknown chi element '" << r
+                      << "' (ssp, sps, pss, ppp or xyz-type tensor element)\n";
+            return false;
+        }
+
+        plan.elements.push_back(idx);
+        plan.labels.push_back(label);
+    }
+
+    if (plan.elements.empty()) {
+        std::cerr << "ERROR: no chi elements requested\n";
+        return false;
+    }
+    return true;
+}
+
+
+// -----------------------------------------------------------------------------
+// MATLAB-equivalent χ² computation; sel(k, out) writes the plan elements of
+// exciton k, to_lab(out) fills out.chi_lab from out.chi_mol (plan.full only)
+// -----------------------------------------------------------------------------
+template<typename Select, typename ToLab>
+static Chi2Result compute_chi2(const HamiltonianEquivResult& H, const Chi2Plan& plan,
+                               Select sel, ToLab to_lab)
 {
     Chi2Result out;
     int N = H.N;
@@ -47,9 +98,13 @@ Chi2Result compute_chi2_matlab(
     }
 
     out.N = N;
+    out.nsel = static_cast<int>(plan.elements.size());
     out.freq.resize(N);
-    out.chi_mol.resize(N);
-    out.chi_lab.resize(N);
+    out.chi_sel.resize((size_t)N * out.nsel);
+    if (plan.full) {
+        out.chi_mol.resize(N);
+        out.chi_lab.resize(N);
+    }
 
 
 
@@ -59,18 +114,66 @@ Chi2Result compute_chi2_matlab(
         // frequency
         out.freq[k] = H.Sort_Ex_Freq[k];
 
-        // exciton μ and α
-        const Vec3& mu_ex = H.mu_ex[k];
-        const std::array<double,9>& alpha_ex = H.alpha_ex[k];
+        // requested lab-frame elements
+        sel(k, &out.chi_sel[(size_t)k * out.nsel]);
 
         // Compute χ_mol 
-        out.chi_mol[k] = outer_alpha_mu(alpha_ex, mu_ex);
-
-        // Rotate to lab frame
-        out.chi_lab[k] = apply_R3_single(R, out.chi_mol[k]);
+        if (plan.full)
+            out.chi_mol[k] = outer_alpha_mu(H.alpha_ex[k], H.mu_ex[k]);
     }
 
+    // Rotate to lab frame
+    if (plan.full)
+        to_lab(out);
 
 
     return out;
 }
+
+
+Chi2Result compute_chi2_matlab(
+    const HamiltonianEquivResult& H,
+    const R3Matrix& R,
+    const Chi2Plan& plan)
+{
+    const int nsel = static_cast<int>(plan.elements.size());
+
+    return compute_chi2(H, plan,
+        [&](int k, double* chi_sel) {
+            // rows of R3 for the plan elements only
+            const std::array<double,9>& a = H.alpha_ex[k];
+            const double m[3] = { H.mu_ex[k].x, H.mu_ex[k].y, H.mu_ex[k].z };
+            for (int e = 0; e < nsel; e++) {
+                const double* row = R.m[plan.elements[e]];
+                double sum = 0.0;
+                for (int b = 0; b < 3; b++)
+                    for (int i = 0; i < 9; i++)
+                        sum += row[i + 9 * b] * (a[i] * m[b]);
+                chi_sel[e] = sum;
+            }
+        },
+        [&](Chi2Result& out) {
+            // all excitons in one pass over the 7 distinct rows of R3
+            apply_R3_sparse_batch(make_R3_sparse(R), out.chi_mol[0].data(),
+                                  out.chi_lab[0].data(), out.N);
+        });
+}
+
+
+Chi2Result compute_chi2_matlab(
+    const HamiltonianEquivResult& H,
+    const R3Rotation& R,
+    const Chi2Plan& plan)
+{
+    const int nsel = static_cast<int>(plan.elements.size());
+
+    return compute_chi2(H, plan,
+        [&](int k, double* chi_sel) {
+            apply_R3_rotation_elements(R, H.alpha_ex[k], H.mu_ex[k],
+                                       plan.elements.data(), nsel, chi_sel);
+        },
+        [&](Chi2Result& out) {
+            for (int k = 0; k < out.N; k++)
+                out.chi_lab[k] = apply_R3_rotation(R, H.alpha_ex[k], H.mu_ex[k]);
+        });
+}
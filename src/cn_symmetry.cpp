@@ -0,0 +1,200 @@
+#include "cn_symmetry.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+
+static const int SITE_NCOL = 12;
+
+// Dipoles of partner sites must agree to this fraction of |mu|
+static const double CN_DIPOLE_TOL = 0.05;
+
+
+// Rotation by angle about unit axis u (Rodrigues), row-major 3×3
+static void axis_rotation(const Vec3& u, double angle, double R[3][3])
+{
+    const double c = std::cos(angle), s = std::sin(angle), t = 1.0 - c;
+    R[0][0] = t * u.x * u.x + c;       R[0][1] = t * u.x * u.y - s * u.z; R[0][2] = t * u.x * u.z + s * u.y;
+    R[1][0] = t * u.x * u.y + s * u.z; R[1][1] = t * u.y * u.y + c;       R[1][2] = t * u.y * u.z - s * u.x;
+    R[2][0] = t * u.x * u.z - s * u.y; R[2][1] = t * u.y * u.z + s * u.x; R[2][2] = t * u.z * u.z + c;
+}
+
+static Vec3 apply(const double R[3][3], const Vec3& v)
+{
+    return {
+        R[0][0] * v.x + R[0][1] * v.y + R[0][2] * v.z,
+        R[1][0] * v.x + R[1][1] * v.y + R[1][2] * v.z,
+        R[2][0] * v.x + R[2][1] * v.y + R[2][2] * v.z
+    };
+}
+
+
+// Largest deviation of site / dipole p+1 from C applied to site / dipole p
+static void cn_deviation(const AmideModeTable& modes,
+                         const CnSymmetry& sym,
+                         double& dpos, double& dmu)
+{
+    const int N = modes.N;
+    const int m = N / sym.n;
+
+    double R[3][3];
+    axis_rotation(sym.axis, 2.0 * M_PI / sym.n, R);
+
+    dpos = 0.0;
+    dmu  = 0.0;
+    for (int p = 0; p < sym.n; p++) {
+        const int q = (p + 1) % sym.n;
+        for (int s = 0; s < m; s++) {
+            const int i = p * m + s, j = q * m + s;
+
+            Vec3 r = apply(R, modes.center(i) - sym.center) + sym.center;
+            dpos = std::max(dpos, norm(r - modes.center(j)));
+
+            const Vec3 mu = modes.mu(i);
+            double ref = std::max(norm(mu), 1e-12);
+            dmu = std::max(dmu, norm(apply(R, mu) - modes.mu(j)) / ref);
+        }
+    }
+}
+
+
+bool detect_cn_symmetry(
+    const AmideModeTable& modes,
+    int n,
+    const Vec3& axis_hint,
+    double tol,
+    CnSymmetry& sym)
+{
+    const int N = modes.N;
+    if (n < 2 || N % n != 0) {
+        std::cerr << "ERROR: " << N << " modes cannot form " << n
+                  << " equal subunits (symmetry_n)\n";
+        return false;
+    }
+    const int m = N / n;
+
+    sym.n = n;
+    sym.center = {0.0, 0.0, 0.0};
+    for (int i = 0; i < N; i++) sym.center = sym.center + modes.center(i);
+    sym.center = sym.center / N;
+
+    Vec3 u = axis_hint;
+    if (norm(u) == 0.0)
+    {
+        if (n >= 3) {
+            // normal of the ring of subunit centroids
+            std::vector<Vec3> c(n, Vec3{0.0, 0.0, 0.0});
+            for (int p = 0; p < n; p++) {
+                for (int s = 0; s < m; s++)
+                    c[p] = c[p] + modes.center(p * m + s);
+                c[p] = c[p] / m - sym.center;
+            }
+            u = {0.0, 0.0, 0.0};
+            for (int p = 0; p < n; p++) u = u + cross(c[p], c[(p + 1) % n]);
+        } else {
+            // C2: the midpoint of two partner sites lies on the axis
+            double best = 0.0;
+            for (int s = 0; s < m; s++) {
+                Vec3 mid = (modes.center(s) + modes.center(m + s)) * 0.5 - sym.center;
+                if (norm(mid) > best) { best = norm(mid); u = mid; }
+            }
+        }
+    }
+
+    if (norm(u) < 1e-8) {
+        std::cerr << "ERROR: cannot determine the C" << n
+                  << " axis, give symmetry_axis\n";
+        return false;
+    }
+
+    // either sense of rotation
+    double dpos = 0.0, dmu = 0.0;
+    for (double sign : { 1.0, -1.0 }) {
+        sym.axis = normalize(u) * sign;
+        cn_deviation(modes, sym, dpos, dmu);
+        if (dpos <= tol && dmu <= CN_DIPOLE_TOL) return true;
+    }
+
+    std::cerr << "ERROR: structure is not C" << n << " symmetric (site deviation "
+              << dpos << " A, dipole " << dmu << "); check symmetry_n, "
+              << "symmetry_axis and that the subunits are stored one after another\n";
+    return false;
+}
+
+
+int cn_sfg_blocks(
+    const CnSymmetry& sym,
+    const std::vector<double>& H,
+    const std::vector<double>& M,
+    std::vector<double>& Hb,
+    std::vector<double>& Mb)
+{
+    const int n = sym.n;
+    const int N = static_cast<int>(M.size() / SITE_NCOL);
+    const int m = N / n;
+
+    auto h = [&](int i, int j) {
+        return (i >= j) ? H[(size_t)i * N + j] : H[(size_t)j * N + i];
+    };
+
+    // G_q(s,t) = <s,p| H |t,p+q>, averaged over p
+    std::vector<double> G((size_t)n * m * m, 0.0);
+    for (int q = 0; q < n; q++) {
+        double* g = &G[(size_t)q * m * m];
+        for (int p = 0; p < n; p++) {
+            const int r0 = p * m, c0 = ((p + q) % n) * m;
+            for (int s = 0; s < m; s++)
+                for (int t = 0; t < m; t++)
+                    g[s * m + t] += h(r0 + s, c0 + t);
+        }
+        for (int k = 0; k < m * m; k++) g[k] /= n;
+    }
+
+    // real basis functions over the subunit index p: k = 0, then the
+    // k = ±1 pair as cos / sin (a single (-1)^p function for C2)
+    std::vector<std::vector<double>> f;
+    f.emplace_back(n, 1.0 / std::sqrt((double)n));
+    if (n == 2) {
+        f.push_back({ 1.0 / std::sqrt(2.0), -1.0 / std::sqrt(2.0) });
+    } else {
+        std::vector<double> fc(n), fs(n);
+        for (int p = 0; p < n; p++) {
+            fc[p] = std::sqrt(2.0 / n) * std::cos(2.0 * M_PI * p / n);
+            fs[p] = std::sqrt(2.0 / n) * std::sin(2.0 * M_PI * p / n);
+        }
+        f.push_back(fc);
+        f.push_back(fs);
+    }
+    const int nf = static_cast<int>(f.size());
+    const int K  = nf * m;
+
+    // <s,a| H |t,b> = sum_q w_ab(q) G_q(s,t),  w_ab(q) = sum_p f_a(p) f_b(p+q)
+    Hb.assign((size_t)K * K, 0.0);
+    for (int a = 0; a < nf; a++)
+        for (int b = 0; b < nf; b++)
+            for (int q = 0; q < n; q++)
+            {
+                double w = 0.0;
+                for (int p = 0; p < n; p++) w += f[a][p] * f[b][(p + q) % n];
+                if (std::fabs(w) < 1e-14) continue;
+
+                const double* g = &G[(size_t)q * m * m];
+                for (int s = 0; s < m; s++)
+                    for (int t = 0; t < m; t++)
+                        Hb[(size_t)(a * m + s) * K + b * m + t] += w * g[s * m + t];
+            }
+
+    // moments of the basis states
+    Mb.assign((size_t)K * SITE_NCOL, 0.0);
+    for (int a = 0; a < nf; a++)
+        for (int s = 0; s < m; s++) {
+            double* mb = &Mb[(size_t)(a * m + s) * SITE_NCOL];
+            for (int p = 0; p < n; p++) {
+                const double* ms = &M[(size_t)(p * m + s) * SITE_NCOL];
+                for (int c = 0; c < SITE_NCOL; c++) mb[c] += f[a][p] * ms[c];
+            }
+        }
+
+    return K;
+}
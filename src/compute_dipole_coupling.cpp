@@ -1,4 +1,5 @@
 #include "compute_dipole_coupling.hpp"
+#include <algorithm>
 #include <cmath>
 
 double compute_dipole_coupling(
@@ -45,3 +46,63 @@ double compute_dipole_coupling(
 
     return beta;
 }
+
+
+// Rows per OpenMP task. Row i costs i pairs (lower triangle), so tiles are
+// handed out dynamically, longest rows first.
+static const int COUPLING_ROW_TILE = 16;
+
+
+void build_dipole_coupling_matrix(
+    const DipoleSitesSoA& s,
+    double prefactor,
+    double* H,
+    int N
+)
+{
+    const double* x   = s.x.data();
+    const double* y   = s.y.data();
+    const double* z   = s.z.data();
+    const double* mux = s.mux.data();
+    const double* muy = s.muy.data();
+    const double* muz = s.muz.data();
+
+    const int ntiles = (N + COUPLING_ROW_TILE - 1) / COUPLING_ROW_TILE;
+
+    // row by row: j < i is contiguous in memory
+    #pragma omp parallel for schedule(dynamic, 1) if (N >= 256)
+    for (int t = ntiles - 1; t >= 0; t--)
+    {
+        const int i0 = t * COUPLING_ROW_TILE;
+        const int i1 = std::min(N, i0 + COUPLING_ROW_TILE);
+
+        for (int i = i0; i < i1; i++)
+        {
+            const double xi = x[i], yi = y[i], zi = z[i];
+            const double mxi = mux[i], myi = muy[i], mzi = muz[i];
+            double* row = H + (size_t)i * N;
+
+            #pragma omp simd
+            for (int j = 0; j < i; j++)
+            {
+                double dx = xi - x[j];
+                double dy = yi - y[j];
+                double dz = zi - z[j];
+                double R2 = dx * dx + dy * dy + dz * dz;
+
+                double r = rsqrt_newton(R2);
+                double inv2 = r * r;
+                double inv3 = inv2 * r;
+
+                double muIdotJ = mxi * mux[j] + myi * muy[j] + mzi * muz[j];
+                double RdotI   = dx * mxi + dy * myi + dz * mzi;
+                double RdotJ   = dx * mux[j] + dy * muy[j] + dz * muz[j];
+
+                double beta = prefactor * inv3 * (muIdotJ - 3.0 * RdotI * RdotJ * inv2);
+
+                // same site -> no coupling
+                row[j] = (R2 > 0.0) ? beta : 0.0;
+            }
+        }
+    }
+}
@@ -0,0 +1,300 @@
+#include "coupling_model.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+
+// ---------------------------------------------------------------------------
+// TDC
+// ---------------------------------------------------------------------------
+TDCCoupling::TDCCoupling(double prefactor)
+    : prefactor_(prefactor)
+{
+}
+
+double TDCCoupling::default_prefactor()
+{
+    return 5034.0 * std::pow((4.1058 / std::sqrt(1600.0)) * 3.144, 2);
+}
+
+void TDCCoupling::fill_couplings(
+    const AmideModeTable& /*modes*/,
+    const DipoleSitesSoA& sites,
+    double* H,
+    int N) const
+{
+    build_dipole_coupling_matrix(sites, prefactor_, H, N);
+}
+
+
+// ---------------------------------------------------------------------------
+// Periodic bicubic table
+// ---------------------------------------------------------------------------
+
+// Regular spacing of sorted, unique grid values; 0 if irregular or not
+// covering exactly 360 degrees
+static double grid_step(const std::vector<double>& v)
+{
+    if (v.size() < 4) return 0.0;
+
+    double h = 360.0 / v.size();
+    for (size_t k = 1; k < v.size(); k++)
+        if (std::fabs(v[k] - v[k - 1] - h) > 1e-6 * h) return 0.0;
+
+    return h;
+}
+
+void PeriodicBicubic::load(const std::string& filename)
+{
+    std::ifstream fin(filename);
+    if (!fin)
+        throw std::runtime_error("Cannot open NN coupling map " + filename);
+
+    std::vector<double> P, S, F;
+    std::string line;
+    while (std::getline(fin, line)) {
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+
+        std::istringstream ss(line);
+        double p, s, f;
+        if (!(ss >> p >> s >> f)) continue;
+
+        // fold into [-180, 180)
+        p -= 360.0 * std::floor((p + 180.0) / 360.0);
+        s -= 360.0 * std::floor((s + 180.0) / 360.0);
+        P.push_back(p);
+        S.push_back(s);
+        F.push_back(f);
+    }
+
+    auto unique_sorted = [](std::vector<double> v) {
+        std::sort(v.begin(), v.end());
+        v.erase(std::unique(v.begin(), v.end(),
+                            [](double a, double b) { return std::fabs(a - b) < 1e-6; }),
+                v.end());
+        return v;
+    };
+    std::vector<double> up = unique_sorted(P);
+    std::vector<double> us = unique_sorted(S);
+
+    hphi_ = grid_step(up);
+    hpsi_ = grid_step(us);
+    if (hphi_ == 0.0 || hpsi_ == 0.0)
+        throw std::runtime_error("NN coupling map " + filename +
+                                 " is not a complete regular phi/psi grid over 360 deg");
+
+    nphi_ = static_cast<int>(up.size());
+    npsi_ = static_cast<int>(us.size());
+    phi0_ = up.front();
+    psi0_ = us.front();
+
+    // Maps that list both -180 and +180 fold the +180 row / column onto
+    // -180; such a point is kept once, and both copies must agree.
+    std::vector<double> f((size_t)nphi_ * npsi_, 0.0);
+    std::vector<char> have(f.size(), 0);
+    size_t filled = 0;
+    for (size_t k = 0; k < F.size(); k++) {
+        int i = static_cast<int>(std::lround((P[k] - phi0_) / hphi_));
+        int j = static_cast<int>(std::lround((S[k] - psi0_) / hpsi_));
+        size_t c = (size_t)i * npsi_ + j;
+        if (have[c]) {
+            if (std::fabs(F[k] - f[c]) > 1e-6 * std::max(1.0, std::fabs(f[c])))
+                throw std::runtime_error("NN coupling map " + filename +
+                                         " has different values for (phi, psi) = (" +
+                                         std::to_string(P[k]) + ", " + std::to_string(S[k]) +
+                                         ") after folding into [-180, 180)");
+            continue;
+        }
+        f[c] = F[k];
+        have[c] = 1;
+        filled++;
+    }
+    if (filled != f.size())
+        throw std::runtime_error("NN coupling map " + filename +
+                                 " is not a complete regular phi/psi grid over 360 deg");
+
+    auto at = [&](int i, int j) {
+        i = (i + nphi_) % nphi_;
+        j = (j + npsi_) % npsi_;
+        return f[(size_t)i * npsi_ + j];
+    };
+
+    // Hermite form per cell: a = C F C', with F holding values and
+    // derivatives (in grid units) at the four corners
+    static const double C[4][4] = {
+        {  1,  0,  0,  0 },
+        {  0,  0,  1,  0 },
+        { -3,  3, -2, -1 },
+        {  2, -2,  1,  1 }
+    };
+
+    coef_.assign((size_t)nphi_ * npsi_ * 16, 0.0);
+
+    for (int i = 0; i < nphi_; i++) {
+        for (int j = 0; j < npsi_; j++) {
+            double Fm[4][4];
+            for (int di = 0; di < 2; di++) {
+                for (int dj = 0; dj < 2; dj++) {
+                    int a = i + di, b = j + dj;
+                    double fx  = 0.5  * (at(a + 1, b) - at(a - 1, b));
+                    double fy  = 0.5  * (at(a, b + 1) - at(a, b - 1));
+                    double fxy = 0.25 * (at(a + 1, b + 1) - at(a + 1, b - 1)
+                                       - at(a - 1, b + 1) + at(a - 1, b - 1));
+                    Fm[di][dj]         = at(a, b);
+                    Fm[di][2 + dj]     = fy;
+                    Fm[2 + di][dj]     = fx;
+                    Fm[2 + di][2 + dj] = fxy;
+                }
+            }
+
+            double T[4][4] = {};
+            for (int r = 0; r < 4; r++)
+                for (int c = 0; c < 4; c++)
+                    for (int k = 0; k < 4; k++)
+                        T[r][c] += C[r][k] * Fm[k][c];
+
+            double* a = &coef_[((size_t)i * npsi_ + j) * 16];
+            for (int r = 0; r < 4; r++)
+                for (int c = 0; c < 4; c++) {
+                    double acc = 0.0;
+                    for (int k = 0; k < 4; k++) acc += T[r][k] * C[c][k];
+                    a[r * 4 + c] = acc;
+                }
+        }
+    }
+}
+
+void PeriodicBicubic::eval(const double* phi, const double* psi,
+                           double* out, int n) const
+{
+    const double* coef = coef_.data();
+    const int    np = nphi_, ns = npsi_;
+    const double p0 = phi0_, s0 = psi0_;
+    const double ip = 1.0 / hphi_, is = 1.0 / hpsi_;
+
+    #pragma omp simd
+    for (int k = 0; k < n; k++)
+    {
+        double u = (phi[k] - p0) * ip;
+        double v = (psi[k] - s0) * is;
+        u -= np * std::floor(u / np);
+        v -= ns * std::floor(v / ns);
+
+        int i = std::min(static_cast<int>(u), np - 1);
+        int j = std::min(static_cast<int>(v), ns - 1);
+        double t = u - i;
+        double s = v - j;
+
+        const double* a = coef + ((size_t)i * ns + j) * 16;
+
+        double r3 = ((a[15] * s + a[14]) * s + a[13]) * s + a[12];
+        double r2 = ((a[11] * s + a[10]) * s + a[9])  * s + a[8];
+        double r1 = ((a[7]  * s + a[6])  * s + a[5])  * s + a[4];
+        double r0 = ((a[3]  * s + a[2])  * s + a[1])  * s + a[0];
+
+        out[k] = ((r3 * t + r2) * t + r1) * t + r0;
+    }
+}
+
+
+// ---------------------------------------------------------------------------
+// TDC + nearest-neighbour map
+// ---------------------------------------------------------------------------
+void NNMapCoupling::fill_couplings(
+    const AmideModeTable& modes,
+    const DipoleSitesSoA& sites,
+    double* H,
+    int N) const
+{
+    tdc_.fill_couplings(modes, sites, H, N);
+
+    // bonded pairs (i, i+1): gather dihedrals, evaluate the map as one
+    // batch, scatter into H(i+1, i)
+    std::vector<int> pair;
+    std::vector<double> phi, psi;
+    for (int i = 0; i + 1 < N; i++) {
+        if (std::isnan(modes.nn_phi[i]) || std::isnan(modes.nn_psi[i])) continue;
+        pair.push_back(i);
+        phi.push_back(modes.nn_phi[i]);
+        psi.push_back(modes.nn_psi[i]);
+    }
+
+    std::vector<double> J(pair.size());
+    map_.eval(phi.data(), psi.data(), J.data(), static_cast<int>(pair.size()));
+
+    for (size_t k = 0; k < pair.size(); k++) {
+        int i = pair[k];
+        H[(size_t)(i + 1) * N + i] = J[k];
+    }
+}
+
+
+// ---------------------------------------------------------------------------
+// Periodic monolayer (k = 0)
+// ---------------------------------------------------------------------------
+PeriodicTDCCoupling::PeriodicTDCCoupling(const Lattice2D& lattice, double prefactor)
+    : lattice_(lattice), prefactor_(prefactor)
+{
+}
+
+static bool same_sites(const DipoleSitesSoA& a, const DipoleSitesSoA& b)
+{
+    return a.x == b.x && a.y == b.y && a.z == b.z &&
+           a.mux == b.mux && a.muy == b.muy && a.muz == b.muz;
+}
+
+void PeriodicTDCCoupling::fill_couplings(
+    const AmideModeTable& /*modes*/,
+    const DipoleSitesSoA& sites,
+    double* H,
+    int N) const
+{
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+
+    if (!same_sites(sites, cache_sites_) || cache_J_.size() != (size_t)N * N) {
+        cache_J_.assign((size_t)N * N, 0.0);
+        build_periodic_dipole_coupling_matrix(sites, prefactor_, lattice_,
+                                              cache_J_.data(), N);
+        cache_sites_ = sites;
+    }
+
+    for (int i = 0; i < N; i++) {
+        const double* src = &cache_J_[(size_t)i * N];
+        double* dst = H + (size_t)i * N;
+        std::copy(src, src + i, dst);
+        dst[i] += src[i];
+    }
+}
+
+
+std::unique_ptr<CouplingModel> make_coupling_model(
+    const std::string& model,
+    const std::string& nn_map_file,
+    const Lattice2D& lattice)
+{
+    if (model == "tdc")
+        return std::unique_ptr<CouplingModel>(new TDCCoupling());
+
+    if (model == "tdc_nn") {
+        PeriodicBicubic map;
+        map.load(nn_map_file);
+
+        std::cout << "[coupling] NN map " << nn_map_file << ": "
+                  << map.n_phi() << " x " << map.n_psi() << " grid\n";
+        return std::unique_ptr<CouplingModel>(new NNMapCoupling(std::move(map)));
+    }
+
+    if (model == "tdc_periodic") {
+        std::cout << "[coupling] periodic monolayer, cell area "
+                  << norm(cross(lattice.a, lattice.b)) << " A^2, lattice sum to "
+                  << lattice.cutoff << " A\n";
+        return std::unique_ptr<CouplingModel>(new PeriodicTDCCoupling(lattice));
+    }
+
+    throw std::runtime_error("Unknown coupling_model " + model);
+}
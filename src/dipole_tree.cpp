@@ -0,0 +1,237 @@
+#include "dipole_tree.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+// Sites per leaf: below this a direct sum beats further splitting
+static const int TREE_LEAF_SIZE = 16;
+static const int TREE_MAX_DEPTH = 32;
+
+
+DipoleTreeOperator::DipoleTreeOperator(
+    const DipoleSitesSoA& s, double prefactor, double theta)
+    : n_(static_cast<int>(s.x.size())),
+      prefactor_(prefactor),
+      theta2_(theta * theta)
+{
+    order_.resize(n_);
+    for (int i = 0; i < n_; i++) order_[i] = i;
+    if (n_ == 0) return;
+
+    // cubic root box
+    double lo[3] = { s.x[0], s.y[0], s.z[0] };
+    double hi[3] = { s.x[0], s.y[0], s.z[0] };
+    for (int i = 0; i < n_; i++) {
+        lo[0] = std::min(lo[0], s.x[i]); hi[0] = std::max(hi[0], s.x[i]);
+        lo[1] = std::min(lo[1], s.y[i]); hi[1] = std::max(hi[1], s.y[i]);
+        lo[2] = std::min(lo[2], s.z[i]); hi[2] = std::max(hi[2], s.z[i]);
+    }
+    double edge = std::max({ hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2], 1e-6 });
+
+    // build() reads coordinates through order_, so fill the SoA copy in
+    // input order first and permute afterwards
+    x_ = s.x; y_ = s.y; z_ = s.z;
+
+    nodes_.emplace_back();
+    build(0, 0, n_, lo[0], lo[1], lo[2], edge * (1.0 + 1e-12), 0);
+
+    std::vector<double> tmp(n_);
+    auto permute = [&](std::vector<double>& dst, const std::vector<double>& src) {
+        for (int t = 0; t < n_; t++) tmp[t] = src[order_[t]];
+        dst = tmp;
+    };
+    permute(x_, s.x);   permute(y_, s.y);   permute(z_, s.z);
+    permute(mux_, s.mux); permute(muy_, s.muy); permute(muz_, s.muz);
+}
+
+
+// Fills nodes_[self] (reserved by the caller) for the sites order_[begin,end)
+// inside the box (x0, y0, z0) + [0, edge)^3
+void DipoleTreeOperator::build(int self, int begin, int end,
+                               double x0, double y0, double z0,
+                               double edge, int depth)
+{
+    Node nd;
+    nd.begin = begin;
+    nd.end   = end;
+
+    double lo[3] = { 1e300, 1e300, 1e300 }, hi[3] = { -1e300, -1e300, -1e300 };
+    for (int t = begin; t < end; t++) {
+        int i = order_[t];
+        nd.cx += x_[i]; nd.cy += y_[i]; nd.cz += z_[i];
+        lo[0] = std::min(lo[0], x_[i]); hi[0] = std::max(hi[0], x_[i]);
+        lo[1] = std::min(lo[1], y_[i]); hi[1] = std::max(hi[1], y_[i]);
+        lo[2] = std::min(lo[2], z_[i]); hi[2] = std::max(hi[2], z_[i]);
+    }
+    const int cnt = end - begin;
+    nd.cx /= cnt; nd.cy /= cnt; nd.cz /= cnt;
+
+    // node size: distance from the centroid to the farthest box corner, x2
+    double r2 = 0.0;
+    for (int a = 0; a < 3; a++) {
+        double c = (a == 0) ? nd.cx : (a == 1) ? nd.cy : nd.cz;
+        double m = std::max(c - lo[a], hi[a] - c);
+        r2 += m * m;
+    }
+    nd.size = 2.0 * std::sqrt(r2);
+
+    nodes_[self] = nd;
+    if (cnt <= TREE_LEAF_SIZE || depth >= TREE_MAX_DEPTH || nd.size == 0.0)
+        return;
+
+    // partition into octants of the current box (counting sort)
+    const double h = 0.5 * edge;
+    const double xm = x0 + h, ym = y0 + h, zm = z0 + h;
+
+    auto octant = [&](int i) {
+        return (x_[i] >= xm ? 1 : 0) | (y_[i] >= ym ? 2 : 0) | (z_[i] >= zm ? 4 : 0);
+    };
+
+    int count[8] = {};
+    for (int t = begin; t < end; t++) count[octant(order_[t])]++;
+
+    int start[9];
+    start[0] = begin;
+    for (int o = 0; o < 8; o++) start[o + 1] = start[o] + count[o];
+
+    std::vector<int> part(cnt);
+    int fill[8];
+    for (int o = 0; o < 8; o++) fill[o] = start[o] - begin;
+    for (int t = begin; t < end; t++) {
+        int i = order_[t];
+        part[fill[octant(i)]++] = i;
+    }
+    std::copy(part.begin(), part.end(), order_.begin() + begin);
+
+    // reserve the children contiguously, then build each
+    int nchild = 0;
+    for (int o = 0; o < 8; o++) if (count[o] > 0) nchild++;
+
+    const int first = static_cast<int>(nodes_.size());
+    nodes_.resize(nodes_.size() + nchild);
+    nodes_[self].child  = first;
+    nodes_[self].nchild = nchild;
+
+    int k = 0;
+    for (int o = 0; o < 8; o++) {
+        if (count[o] == 0) continue;
+        build(first + k++, start[o], start[o + 1],
+              (o & 1) ? xm : x0, (o & 2) ? ym : y0, (o & 4) ? zm : z0,
+              h, depth + 1);
+    }
+}
+
+
+void DipoleTreeOperator::apply(const double* x, double* y) const
+{
+    const int nn = static_cast<int>(nodes_.size());
+    if (n_ == 0) return;
+
+    // ---- upward pass: P (3) and Q (3×3, Q[m][k] = sum p_m (r - c)_k) ----
+    std::vector<double> P((size_t)nn * 3, 0.0), Q((size_t)nn * 9, 0.0);
+
+    for (int a = nn - 1; a >= 0; a--)
+    {
+        const Node& nd = nodes_[a];
+        double* p = &P[(size_t)a * 3];
+        double* q = &Q[(size_t)a * 9];
+
+        if (nd.nchild == 0) {
+            for (int t = nd.begin; t < nd.end; t++) {
+                double w = x[order_[t]];
+                double pm[3] = { w * mux_[t], w * muy_[t], w * muz_[t] };
+                double dk[3] = { x_[t] - nd.cx, y_[t] - nd.cy, z_[t] - nd.cz };
+                for (int m = 0; m < 3; m++) {
+                    p[m] += pm[m];
+                    for (int k = 0; k < 3; k++) q[m * 3 + k] += pm[m] * dk[k];
+                }
+            }
+            continue;
+        }
+
+        // children: Q_parent = sum (Q_child + P_child (c_child - c_parent)^T)
+        for (int c = nd.child; c < nd.child + nd.nchild; c++) {
+            const double* pc = &P[(size_t)c * 3];
+            const double* qc = &Q[(size_t)c * 9];
+            double dk[3] = { nodes_[c].cx - nd.cx, nodes_[c].cy - nd.cy, nodes_[c].cz - nd.cz };
+            for (int m = 0; m < 3; m++) {
+                p[m] += pc[m];
+                for (int k = 0; k < 3; k++) q[m * 3 + k] += qc[m * 3 + k] + pc[m] * dk[k];
+            }
+        }
+    }
+
+    // ---- per-target traversal ----
+    #pragma omp parallel for schedule(dynamic, 64) if (n_ >= 2048)
+    for (int t = 0; t < n_; t++)
+    {
+        const double rx = x_[t], ry = y_[t], rz = z_[t];
+        double ex = 0.0, ey = 0.0, ez = 0.0;
+
+        int stack[8 * TREE_MAX_DEPTH + 8];
+        int top = 0;
+        stack[top++] = 0;
+
+        while (top > 0)
+        {
+            const int a = stack[--top];
+            const Node& nd = nodes_[a];
+
+            double dx = rx - nd.cx, dy = ry - nd.cy, dz = rz - nd.cz;
+            double d2 = dx * dx + dy * dy + dz * dz;
+
+            if (nd.size * nd.size < theta2_ * d2)
+            {
+                // far node: dipole + first-moment expansion about its centre
+                const double* p = &P[(size_t)a * 3];
+                const double* q = &Q[(size_t)a * 9];
+                double d[3] = { dx, dy, dz };
+
+                double inv2 = 1.0 / d2;
+                double inv  = std::sqrt(inv2);
+                double inv3 = inv * inv2, inv5 = inv3 * inv2, inv7 = inv5 * inv2;
+
+                double dp = d[0] * p[0] + d[1] * p[1] + d[2] * p[2];
+                double Qd[3], QTd[3], trQ = q[0] + q[4] + q[8], dQd = 0.0;
+                for (int m = 0; m < 3; m++) {
+                    Qd[m]  = q[m * 3 + 0] * d[0] + q[m * 3 + 1] * d[1] + q[m * 3 + 2] * d[2];
+                    QTd[m] = q[0 * 3 + m] * d[0] + q[1 * 3 + m] * d[1] + q[2 * 3 + m] * d[2];
+                }
+                for (int m = 0; m < 3; m++) dQd += d[m] * Qd[m];
+
+                double e[3];
+                for (int m = 0; m < 3; m++)
+                    e[m] = p[m] * inv3 - 3.0 * d[m] * dp * inv5
+                         + 3.0 * (Qd[m] + QTd[m] + d[m] * trQ) * inv5
+                         - 15.0 * d[m] * dQd * inv7;
+
+                ex += e[0]; ey += e[1]; ez += e[2];
+            }
+            else if (nd.nchild == 0)
+            {
+                // leaf: direct sum, same-position pairs do not couple
+                #pragma omp simd reduction(+:ex,ey,ez)
+                for (int s = nd.begin; s < nd.end; s++) {
+                    double ddx = rx - x_[s], ddy = ry - y_[s], ddz = rz - z_[s];
+                    double r2 = ddx * ddx + ddy * ddy + ddz * ddz;
+                    double w  = x[order_[s]];
+                    double ir2 = (r2 > 0.0) ? 1.0 / r2 : 0.0;
+                    double ir3 = ir2 * std::sqrt(ir2);
+                    double px = w * mux_[s], py = w * muy_[s], pz = w * muz_[s];
+                    double rp = ddx * px + ddy * py + ddz * pz;
+                    ex += (px - 3.0 * ddx * rp * ir2) * ir3;
+                    ey += (py - 3.0 * ddy * rp * ir2) * ir3;
+                    ez += (pz - 3.0 * ddz * rp * ir2) * ir3;
+                }
+            }
+            else
+            {
+                for (int c = nd.child; c < nd.child + nd.nchild; c++)
+                    stack[top++] = c;
+            }
+        }
+
+        y[order_[t]] = prefactor_ * (mux_[t] * ex + muy_[t] * ey + muz_[t] * ez);
+    }
+}
@@ -0,0 +1,190 @@
+#include "frequency_map.hpp"
+#include "helper_vec3.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+// Bohr radius (Å): field of charge q at r Å is q * A0^2 / r^2 in a.u.
+static const double BOHR_A = 0.529177210903;
+
+
+double partial_charge(const Atom& a)
+{
+    const PDBName& n = a.name;
+    const PDBName& r = a.resName;
+
+    // water (TIP3P); hydrogens must be present for a neutral molecule
+    if (r == "HOH" || r == "WAT" || r == "SOL" || r == "TIP3") {
+        if (n == "O" || n == "OW" || n == "OH2") return -0.834;
+        if (n[0] == 'H')                         return  0.417;
+        return 0.0;
+    }
+
+    // backbone, hydrogens lumped onto N and CA (CHARMM-like, neutral)
+    if (n == "N")  return -0.16;
+    if (n == "CA") return  0.16;
+    if (n == "C")  return  0.51;
+    if (n == "O")  return -0.51;
+
+    // ionized side chains, charge spread over the terminal atoms
+    if (r == "LYS" && n == "NZ")                  return  1.0;
+    if (r == "ARG" && (n == "NH1" || n == "NH2")) return  0.5;
+    if (r == "ASP" && (n == "OD1" || n == "OD2")) return -0.5;
+    if (r == "GLU" && (n == "OE1" || n == "OE2")) return -0.5;
+
+    return 0.0;
+}
+
+
+// ---------------------------------------------------------------------------
+// Cell list of the charged atoms: counting sort by cell, SoA per cell
+// ---------------------------------------------------------------------------
+struct ChargeCells {
+    double cell = 1.0;
+    double x0 = 0.0, y0 = 0.0, z0 = 0.0;
+    int nx = 1, ny = 1, nz = 1;
+
+    std::vector<int> start;                  // size nx*ny*nz + 1
+    std::vector<double> x, y, z, q;          // sorted by cell
+    std::vector<long long> res;              // residue_key
+
+    int coord(double v, double v0, int n) const {
+        int c = static_cast<int>(std::floor((v - v0) / cell));
+        return std::max(0, std::min(n - 1, c));
+    }
+};
+
+static ChargeCells build_charge_cells(const std::vector<Atom>& atoms, double cutoff)
+{
+    ChargeCells g;
+    g.cell = cutoff;
+
+    std::vector<int> idx;
+    std::vector<double> qa;
+    double xmin = 1e300, ymin = 1e300, zmin = 1e300;
+    double xmax = -1e300, ymax = -1e300, zmax = -1e300;
+
+    for (int i = 0; i < (int)atoms.size(); i++) {
+        double q = partial_charge(atoms[i]);
+        if (q == 0.0) continue;
+
+        idx.push_back(i);
+        qa.push_back(q);
+        xmin = std::min(xmin, atoms[i].x); xmax = std::max(xmax, atoms[i].x);
+        ymin = std::min(ymin, atoms[i].y); ymax = std::max(ymax, atoms[i].y);
+        zmin = std::min(zmin, atoms[i].z); zmax = std::max(zmax, atoms[i].z);
+    }
+
+    if (idx.empty()) {
+        g.start.assign(2, 0);
+        return g;
+    }
+
+    g.x0 = xmin; g.y0 = ymin; g.z0 = zmin;
+    g.nx = static_cast<int>((xmax - xmin) / cutoff) + 1;
+    g.ny = static_cast<int>((ymax - ymin) / cutoff) + 1;
+    g.nz = static_cast<int>((zmax - zmin) / cutoff) + 1;
+
+    const int ncell = g.nx * g.ny * g.nz;
+    const int n = static_cast<int>(idx.size());
+
+    std::vector<int> cell_of(n);
+    g.start.assign(ncell + 1, 0);
+    for (int k = 0; k < n; k++) {
+        const Atom& a = atoms[idx[k]];
+        int c = (g.coord(a.x, g.x0, g.nx) * g.ny + g.coord(a.y, g.y0, g.ny)) * g.nz
+              + g.coord(a.z, g.z0, g.nz);
+        cell_of[k] = c;
+        g.start[c + 1]++;
+    }
+    for (int c = 0; c < ncell; c++) g.start[c + 1] += g.start[c];
+
+    g.x.resize(n); g.y.resize(n); g.z.resize(n); g.q.resize(n); g.res.resize(n);
+    std::vector<int> fill(g.start.begin(), g.start.end() - 1);
+    for (int k = 0; k < n; k++) {
+        const Atom& a = atoms[idx[k]];
+        int p = fill[cell_of[k]]++;
+        g.x[p] = a.x; g.y[p] = a.y; g.z[p] = a.z;
+        g.q[p] = qa[k];
+        g.res[p] = residue_key(a);
+    }
+
+    return g;
+}
+
+
+// Field (a.u.) at r from all cell-list charges within the cutoff, skipping
+// residues r1 and r2
+static Vec3 field_at(const ChargeCells& g, const Vec3& r, long long r1, long long r2)
+{
+    const double rc2 = g.cell * g.cell;
+    const int cx = g.coord(r.x, g.x0, g.nx);
+    const int cy = g.coord(r.y, g.y0, g.ny);
+    const int cz = g.coord(r.z, g.z0, g.nz);
+
+    double ex = 0.0, ey = 0.0, ez = 0.0;
+
+    for (int ix = std::max(0, cx - 1); ix <= std::min(g.nx - 1, cx + 1); ix++)
+    for (int iy = std::max(0, cy - 1); iy <= std::min(g.ny - 1, cy + 1); iy++)
+    for (int iz = std::max(0, cz - 1); iz <= std::min(g.nz - 1, cz + 1); iz++)
+    {
+        const int c = (ix * g.ny + iy) * g.nz + iz;
+        const int b = g.start[c], e = g.start[c + 1];
+
+        #pragma omp simd reduction(+:ex,ey,ez)
+        for (int k = b; k < e; k++) {
+            double dx = r.x - g.x[k];
+            double dy = r.y - g.y[k];
+            double dz = r.z - g.z[k];
+            double d2 = dx * dx + dy * dy + dz * dz;
+
+            bool use = d2 < rc2 && d2 > 0.0 && g.res[k] != r1 && g.res[k] != r2;
+            double s = use ? g.q[k] / (d2 * std::sqrt(d2)) : 0.0;
+
+            ex += s * dx;
+            ey += s * dy;
+            ez += s * dz;
+        }
+    }
+
+    const double a2 = BOHR_A * BOHR_A;
+    return Vec3{ ex * a2, ey * a2, ez * a2 };
+}
+
+
+std::vector<double> electrostatic_frequency_shifts(
+    const std::vector<AmideIEntry>& amides,
+    const std::vector<Atom>& atoms,
+    const FrequencyMapParams& params)
+{
+    const int n = static_cast<int>(amides.size());
+    std::vector<double> shift(n, 0.0);
+
+    ChargeCells g = build_charge_cells(atoms, params.cutoff);
+
+    #pragma omp parallel for schedule(static) if (n >= 256)
+    for (int k = 0; k < n; k++)
+    {
+        const AmideIEntry& e = amides[k];
+        Vec3 C = { e.C.x, e.C.y, e.C.z };
+        Vec3 O = { e.O.x, e.O.y, e.O.z };
+        Vec3 N = { e.N.x, e.N.y, e.N.z };
+
+        Vec3 co = O - C;
+        double len = norm(co);
+        if (len == 0.0) continue;
+        co = co / len;
+
+        // own peptide unit: residue of C/O and residue of N
+        const long long r1 = residue_key(e.C), r2 = residue_key(e.N);
+
+        double EC = dot(field_at(g, C, r1, r2), co);
+        double EO = dot(field_at(g, O, r1, r2), co);
+        double EN = dot(field_at(g, N, r1, r2), co);
+
+        shift[k] = params.coef_C * EC + params.coef_O * EO + params.coef_N * EN;
+    }
+
+    return shift;
+}
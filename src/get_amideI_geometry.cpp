@@ -1,6 +1,7 @@
 #include "get_amideI_geometry.hpp"
 #include "helper_vec3.hpp"
 #include <iostream>
+#include <unordered_map>
 
 // -------------------------
 // Compute vibration center
@@ -43,3 +44,48 @@ std::vector<AmideIGeo> get_amideI_geometry(
 
     return geo;
 }
+
+
+// -------------------------
+// Neighbour dihedrals
+// Amide k = C(s-1) O(s-1) N(s), amide k+1 = C(s) O(s) N(s+1): they share
+// residue s, whose phi = C(s-1)-N(s)-CA(s)-C(s), psi = N(s)-CA(s)-C(s)-N(s+1)
+// -------------------------
+void assign_nn_dihedrals(
+    AmideModeTable& modes,
+    const std::vector<AmideIEntry>& amideAtoms,
+    const std::vector<Atom>& atoms)
+{
+    // first CA of every residue (chain, number, insertion code)
+    std::unordered_map<long long, Vec3> CA;
+    for (const auto& a : atoms) {
+        if (a.name == "CA" && !CA.count(residue_key(a)))
+            CA[residue_key(a)] = Vec3{a.x, a.y, a.z};
+    }
+
+    const double max_bond = 2.0;   // Å, N-CA and CA-C are ~1.5
+
+    for (size_t k = 0; k + 1 < amideAtoms.size() && (int)k + 1 < modes.N; k++) {
+
+        const AmideIEntry& e0 = amideAtoms[k];
+        const AmideIEntry& e1 = amideAtoms[k + 1];
+
+        long long s = residue_key(e0.N);
+        if (e0.N.name != "N" || residue_key(e1.C) != s) continue;
+
+        auto it = CA.find(s);
+        if (it == CA.end()) continue;
+
+        Vec3 C0 = {e0.C.x, e0.C.y, e0.C.z};
+        Vec3 N0 = {e0.N.x, e0.N.y, e0.N.z};
+        Vec3 CA0 = it->second;
+        Vec3 C1 = {e1.C.x, e1.C.y, e1.C.z};
+        Vec3 N1 = {e1.N.x, e1.N.y, e1.N.z};
+
+        // misplaced / alternate CA: not bonded
+        if (norm(CA0 - N0) > max_bond || norm(C1 - CA0) > max_bond) continue;
+
+        modes.nn_phi[k] = dihedral_deg(C0, N0, CA0, C1);
+        modes.nn_psi[k] = dihedral_deg(N0, CA0, C1, N1);
+    }
+}
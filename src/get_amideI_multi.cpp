@@ -1,108 +1,93 @@
 #include "get_amideI_multi.hpp"
+#include "amideI_site_kernel.hpp"
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
 
+// Elements a … b (1-based); b = 0: a … last
 template<typename T>
 std::vector<T> slice_vector(const std::vector<T>& v, int a, int b)
 {
+    if (b == 0) b = (int)v.size();
     if (a < 1 || b > (int)v.size() || a > b)
-        throw std::runtime_error("Invalid helix range");
+        throw std::runtime_error("amide_range " + std::to_string(a) + " " + std::to_string(b) +
+                                 " is outside the " + std::to_string(v.size()) +
+                                 " amide-I modes of the structure");
 
     return std::vector<T>(v.begin() + (a - 1), v.begin() + b);
 }
 
-template<typename T>
-std::vector<T> replicate_layer(const std::vector<T>& data, int layer)
+// Copies of one layer at the same coordinates (no offset between copies);
+// a laterally periodic monolayer is coupling_model = tdc_periodic instead.
+// Rows 0 … n-1 (stride values each) are repeated `layer` times.
+static void replicate_layer(std::vector<double>& v, int n, int layer, int stride = 1)
 {
-    std::vector<T> out;
-    out.reserve(data.size() * layer);
-
-    for (int L = 0; L < layer; L++) {
-        out.insert(out.end(), data.begin(), data.end());
-    }
-    return out;
+    const size_t len = (size_t)n * stride;
+    for (int L = 1; L < layer; L++)
+        std::copy_n(v.begin(), len, v.begin() + L * len);
 }
 
 
 
-AmideIMultiOutput Get_AmideI_Multi(
+AmideModeTable Get_AmideI_Multi(
     double center_freq,
     int helix_a,
     int helix_b,
     int layer,
-    const std::string& pdbFile)
+    const std::string& pdbFile,
+    const FrequencyMapParams* freq_map,
+    bool report_chains)
 {
-    AmideIMultiOutput out;
-    auto atoms = Read_PDB_Atoms(pdbFile);
+    // without the frequency map only the backbone atoms are used
+    auto atoms = Read_PDB_Atoms(pdbFile, freq_map == nullptr);
+    return Get_AmideI_Multi(center_freq, helix_a, helix_b, layer, atoms, freq_map,
+                            report_chains);
+}
+
 
-    auto amide_all = Extract_Amide_Coordinates(atoms);
+AmideModeTable Get_AmideI_Multi(
+    double center_freq,
+    int helix_a,
+    int helix_b,
+    int layer,
+    const std::vector<Atom>& atoms,
+    const FrequencyMapParams* freq_map,
+    bool report_chains)
+{
+    auto amide_all = Extract_Amide_Coordinates(atoms, report_chains);
 
     auto amide_seg = slice_vector(amide_all, helix_a, helix_b);
     int ModeNum = amide_seg.size(); //number of mode is the same as the number of amide
 
-    auto geo = get_amideI_geometry(amide_seg);
-
-    auto frames = get_local_frame(geo);
-
-    auto props = get_amideI_properties(frames);
-    
-    auto geo_L     = replicate_layer(geo, layer);
-    auto frames_L  = replicate_layer(frames, layer);
-    auto props_L   = replicate_layer(props, layer);
-    auto amide_L   = replicate_layer(amide_seg, layer);
-    int total_modes = ModeNum * layer;
-
-    out.freq.resize(total_modes, center_freq);
-
-
-    out.anharm.resize(total_modes, 12.0);
-
-    out.center.resize(total_modes);
-    out.mu_orig.resize(total_modes);
-    out.alpha_matrix.resize(total_modes);
-    out.alpha_reduced.resize(total_modes);
-    out.alpha_vectorized.resize(total_modes);
-
-    out.AtomSerNo.resize(total_modes);
-    out.xyz.resize(total_modes);
-
-    out.AtomC.resize(total_modes);
-    out.AtomO.resize(total_modes);
-    out.AtomN.resize(total_modes);
-
-    for (int i = 0; i < total_modes; i++) {
-
-        out.center[i] = geo_L[i].vibration_center_coord;
-        out.mu_orig[i] = props_L[i].dipole_sim;
-        for(int r=0;r<3;r++)
-            for(int c=0;c<3;c++)
-                out.alpha_matrix[i][r*3 + c] = props_L[i].alpha_matrix[r][c];
-
-        {
-            int k = 0;
-            for (int col = 0; col < 3; col++) {
-                for (int row = 0; row < 3; row++) {
-                    out.alpha_vectorized[i][k++] = props_L[i].alpha_matrix[row][col];
-                }
-            }
-        }
-
-        for (int k = 0; k < 6; k++)
-            out.alpha_reduced[i][k] = props_L[i].alpha_reduced[k];
-
-        out.AtomSerNo[i] = {
-            amide_L[i].C.serial,
-            amide_L[i].O.serial,
-            amide_L[i].N.serial
-        };
-
-        out.AtomC[i] = { amide_L[i].C.x, amide_L[i].C.y, amide_L[i].C.z };
-        out.AtomO[i] = { amide_L[i].O.x, amide_L[i].O.y, amide_L[i].O.z };
-        out.AtomN[i] = { amide_L[i].N.x, amide_L[i].N.y, amide_L[i].N.z };
+    // site-specific shifts from the local electrostatic field
+    std::vector<double> shift(ModeNum, 0.0);
+    if (freq_map)
+        shift = electrostatic_frequency_shifts(amide_seg, atoms, *freq_map);
+
+    AmideModeTable out;
+    out.resize(ModeNum * layer);
+
+    // centre, dipole and Raman tensor of every amide in one pass
+    int bad = amideI_site_kernel(amide_seg, out);
+    if (bad >= 0) {
+        const Atom& C = amide_seg[bad].C;
+        throw std::runtime_error(
+            "Degenerate amide geometry (zero-length C=O / C-N or collinear C, O, N) "
+            "at residue " + C.resName.str() + " " + std::to_string(C.resID) +
+            (C.chain != ' ' ? std::string(" chain ") + C.chain : std::string()));
+    }
+    assign_nn_dihedrals(out, amide_seg, atoms);
 
-        out.xyz[i] = { out.AtomC[i], out.AtomO[i], out.AtomN[i] };
+    for (int s = 0; s < ModeNum; s++) {
+        out.freq[s]   = center_freq + shift[s];
+        out.anharm[s] = 12.0;
     }
 
+    for (auto* v : { &out.x, &out.y, &out.z, &out.nn_phi, &out.nn_psi,
+                     &out.mux, &out.muy, &out.muz, &out.freq, &out.anharm })
+        replicate_layer(*v, ModeNum, layer);
+    replicate_layer(out.alpha, ModeNum, layer, 9);
+
     return out;
 }
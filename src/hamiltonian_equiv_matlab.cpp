@@ -1,97 +1,154 @@
 #include "hamiltonian_equiv_matlab.hpp"
-#include "rotate_properties.hpp"
-#include "compute_dipole_coupling.hpp"
+#include "coupling_model.hpp"
+#include "batched_eigensolver.hpp"
+#include "hamiltonian_lanczos.hpp"
+#include "cn_symmetry.hpp"
+#include "thread_scheduler.hpp"
 
 #include <algorithm>
+#include <cblas.h>
 #include <cmath>
 #include <iostream>
 #include <lapacke.h>
+#include <map>
 
 
+// Site property matrix M (N×12, row-major): μ_i in columns 0–2 and α_i
+// (col-major 3×3) in columns 3–11, so that all exciton moments are V'·M.
+static const int SITE_NCOL = 12;
+
+
+// Eigen-decomposition of the symmetric H (N×N row-major, lower triangle).
+// Called as COLUMN-major so LAPACKE works in place without a transposed
+// copy of H: its 'U' triangle is our lower one, and on return
+// eigenvector k is row k of H.
 static bool diagonalize(std::vector<double>& H, int N, std::vector<double>& evals)
 {
     evals.resize(N);
     int info = LAPACKE_dsyev(
-        LAPACK_ROW_MAJOR, 'V', 'U',
+        LAPACK_COL_MAJOR, 'V', 'U',
         N, H.data(), N, evals.data()
     );
     return (info == 0);
 }
 
 
-HamiltonianEquivResult Hamiltonian_equiv_matlab(
-    const std::vector<AmideIGeo>&   geo,
-    const std::vector<AmideIProps>& props,
-    const std::vector<AmideIFreq>&  freqs,
-    double tilt_deg,
-    double twist_deg)
+// Site dipoles / Raman tensors in the rod frame. The orientation enters
+// through R3 only (MATLAB applies no rotation here), so M is gathered
+// straight from the mode table.
+static void set_site_properties(
+    HamiltonianEquivResult& out,
+    const AmideModeTable& modes,
+    bool keep,
+    std::vector<double>& M)
 {
-    HamiltonianEquivResult out;
-
-    int N = static_cast<int>(props.size());
-    if (N == 0) return out;
-    out.N = N;
-
-    
-    auto rotated = rotate_properties(props, tilt_deg, twist_deg);
-
-    out.mu_rot.resize(N);
-    out.alpha_rot.resize(N);
+    int N = out.N;
+    M.resize((size_t)N * SITE_NCOL);
 
     for (int i = 0; i < N; ++i) {
+        double* m = &M[(size_t)i * SITE_NCOL];
+
         // μ (3 components)
-        out.mu_rot[i] = rotated[i].dipole_rot;  // Vec3
+        m[0] = modes.mux[i];
+        m[1] = modes.muy[i];
+        m[2] = modes.muz[i];
 
         // α (9 components in column-major order)
+        const double* a = modes.alpha_of(i);
         for (int k = 0; k < 9; ++k) {
-            out.alpha_rot[i][k] = rotated[i].alpha_rot[k];
+            m[3 + k] = a[k];
         }
     }
-    //build hamiltonian
-    std::vector<double> H(N * N, 0.0);
 
-    // Diagonal: site frequencies
+    if (!keep) return;
+
+    out.mu_rot.resize(N);
+    out.alpha_rot.resize(N);
+
     for (int i = 0; i < N; ++i) {
-        H[i * N + i] = freqs[i].freq;
+        const double* m = &M[(size_t)i * SITE_NCOL];
+        out.mu_rot[i] = Vec3{ m[0], m[1], m[2] };
+        for (int k = 0; k < 9; ++k) {
+            out.alpha_rot[i][k] = m[3 + k];
+        }
     }
+}
+
 
-    // Dipole–dipole coupling prefactor (from MATLAB code)
-    const double prefactor =
-        5034.0 * std::pow((4.1058 / std::sqrt(1600.0)) * 3.144, 2);
+// Coupling sites: vibration centres and rotated dipoles (columns 0–2 of M)
+static DipoleSitesSoA dipole_sites(
+    const AmideModeTable&      modes,
+    const std::vector<double>& M)
+{
+    int N = static_cast<int>(M.size() / SITE_NCOL);
+
+    DipoleSitesSoA sites;
+    sites.x = modes.x;
+    sites.y = modes.y;
+    sites.z = modes.z;
+    sites.mux.resize(N); sites.muy.resize(N); sites.muz.resize(N);
 
     for (int i = 0; i < N; ++i) {
-        const Vec3& Ri  = geo[i].vibration_center_coord;
-        const Vec3& mui = out.mu_rot[i];
+        sites.mux[i] = M[(size_t)i * SITE_NCOL + 0];
+        sites.muy[i] = M[(size_t)i * SITE_NCOL + 1];
+        sites.muz[i] = M[(size_t)i * SITE_NCOL + 2];
+    }
+    return sites;
+}
 
-        for (int j = i + 1; j < N; ++j) {
-            const Vec3& Rj  = geo[j].vibration_center_coord;
-            const Vec3& muj = out.mu_rot[j];
 
-            Vec3 Rij { Ri.x - Rj.x, Ri.y - Rj.y, Ri.z - Rj.z };
+// One-exciton Hamiltonian: site frequencies + transition dipole coupling.
+// Only the diagonal and the lower triangle are filled.
+static void build_hamiltonian(
+    const AmideModeTable&      modes,
+    const std::vector<double>& M,
+    const double*              freq,
+    const CouplingModel*       coupling,
+    std::vector<double>& H)
+{
+    int N = static_cast<int>(M.size() / SITE_NCOL);
+    H.assign((size_t)N * N, 0.0);
 
-            double Jij = compute_dipole_coupling(
-                mui, muj, Rij,
-                1000.0,   // dielectric epsilon, same as before
-                false,    // no screening flag
-                prefactor
-            );
+    DipoleSitesSoA sites = dipole_sites(modes, M);
 
-            H[i * N + j] = Jij;
-            H[j * N + i] = Jij;
-        }
+    // Diagonal: site frequencies
+    for (int i = 0; i < N; ++i) {
+        H[(size_t)i * N + i] = freq[i];
     }
 
+    // Off-diagonal: transition dipole coupling (no dielectric cutoff,
+    // same as before) unless another model is selected
+    static const TDCCoupling tdc;
+    if (!coupling) coupling = &tdc;
 
-    // Diagonalize H → eigenvalues + eigenvectors
-    // H is overwritten with eigenvectors (columns) by LAPACKE_dsyev
-    std::vector<double> evals;
-    if (!diagonalize(H, N, evals)) {
-        std::cerr << "[Hamiltonian_equiv_matlab] LAPACK dsyev failed\n";
-        return out;
-    }
+    coupling->fill_couplings(modes, sites, H.data(), N);
+}
 
 
-    // 4. Sort eigenvalues and eigenvectors ascending (like MATLAB sort)
+// Sorted exciton frequencies and exciton μ, α (optionally eigenvectors).
+// W holds the eigenvectors as ROWS (N×N row-major, any order); if the
+// eigenvectors are kept, W is sorted in place and moved into out.Sort_V.
+static void set_exciton_properties(
+    HamiltonianEquivResult& out,
+    std::vector<double>& W,
+    const std::vector<double>& evals,
+    const std::vector<double>& M,
+    bool keep_eigenvectors)
+{
+    int N = out.N;
+
+    // Exciton moments of all eigenvectors at once (one DGEMM, every
+    // operand unit-stride):
+    // μ_ex(k)   = Σ_i V(i,k) * μ_i
+    // α_ex(k,:) = Σ_i V(i,k) * α_i(:)
+    std::vector<double> E((size_t)N * SITE_NCOL);
+    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                N, SITE_NCOL, N,
+                1.0, W.data(), N, M.data(), SITE_NCOL,
+                0.0, E.data(), SITE_NCOL);
+
+    // 4. Sort eigenvalues ascending (like MATLAB sort); only the N×12
+    //    moments are permuted, not the eigenvectors
     std::vector<int> idx(N);
     for (int i = 0; i < N; ++i) idx[i] = i;
 
@@ -99,52 +156,230 @@ HamiltonianEquivResult Hamiltonian_equiv_matlab(
               [&](int a, int b) { return evals[a] < evals[b]; });
 
     out.Sort_Ex_Freq.resize(N);
-    out.Sort_V.assign(N * N, 0.0);
+    out.mu_ex.resize(N);
+    out.alpha_ex.resize(N);
 
-    for (int newcol = 0; newcol < N; ++newcol) {
-        int oldcol = idx[newcol];
-        out.Sort_Ex_Freq[newcol] = evals[oldcol];
+    for (int k = 0; k < N; ++k) {
+        const double* e = &E[(size_t)idx[k] * SITE_NCOL];
 
-        for (int r = 0; r < N; ++r) {
-            // H(r,oldcol) in row-major → H[r*N + oldcol]
-            out.Sort_V[r * N + newcol] = H[r * N + oldcol];
+        out.Sort_Ex_Freq[k] = evals[idx[k]];
+        out.mu_ex[k] = Vec3{ e[0], e[1], e[2] };
+        for (int t = 0; t < 9; ++t) {
+            out.alpha_ex[k][t] = e[3 + t];
         }
     }
 
+    if (!keep_eigenvectors) return;
 
-    // Compute exciton μ_ex and α_ex:
-    // μ_ex(k)   = Σ_i V(i,k) * μ_i
-    // α_ex(k,:) = Σ_i V(i,k) * α_i(:)
-    out.mu_ex.resize(N);
-    out.alpha_ex.resize(N);
+    // Rows into sorted order, cycle by cycle (one row of scratch); dsyev
+    // output is already ascending, so this is normally a no-op
+    std::vector<double> row(N);
+    std::vector<char> placed(N, 0);
 
-    for (int k = 0; k < N; ++k) {
-        double mx = 0.0, my = 0.0, mz = 0.0;
+    for (int start = 0; start < N; ++start) {
+        if (placed[start]) continue;
+
+        std::copy_n(&W[(size_t)start * N], N, row.data());
+        int k = start;
+        while (true) {
+            placed[k] = 1;
+            int src = idx[k];
+            if (src == start) {
+                std::copy_n(row.data(), N, &W[(size_t)k * N]);
+                break;
+            }
+            std::copy_n(&W[(size_t)src * N], N, &W[(size_t)k * N]);
+            k = src;
+        }
+    }
 
-        for (int i = 0; i < N; ++i) {
-            double vik = out.Sort_V[i * N + k];  // eigenvector component
+    // Transpose in place: eigenvectors as columns, like MATLAB's V
+    for (int i = 0; i < N; ++i)
+        for (int j = i + 1; j < N; ++j)
+            std::swap(W[(size_t)i * N + j], W[(size_t)j * N + i]);
 
-            mx += vik * out.mu_rot[i].x;
-            my += vik * out.mu_rot[i].y;
-            mz += vik * out.mu_rot[i].z;
+    out.Sort_V = std::move(W);
+}
+
+
+// Reduced exciton set (Ritz states) without forming H, see
+// hamiltonian_lanczos.hpp
+static void lanczos_excitons(
+    HamiltonianEquivResult& out,
+    const AmideModeTable&      modes,
+    const std::vector<double>& M,
+    const HamiltonianOptions&  opts)
+{
+    std::vector<double> ritz, E;
+    int K = lanczos_exciton_moments(dipole_sites(modes, M), modes.freq, M,
+                                    TDCCoupling::default_prefactor(),
+                                    opts.tree_theta, opts.lanczos_steps,
+                                    ritz, E);
+
+    // dsyev order is already ascending
+    out.N = K;
+    out.Sort_Ex_Freq = ritz;
+    out.mu_ex.resize(K);
+    out.alpha_ex.resize(K);
+
+    for (int k = 0; k < K; ++k) {
+        const double* e = &E[(size_t)k * SITE_NCOL];
+        out.mu_ex[k] = Vec3{ e[0], e[1], e[2] };
+        for (int t = 0; t < 9; ++t) {
+            out.alpha_ex[k][t] = e[3 + t];
         }
+    }
+}
+
+
+HamiltonianEquivResult Hamiltonian_equiv_matlab(
+    const AmideModeTable& modes,
+    double /*tilt_deg*/,
+    double /*twist_deg*/,
+    const HamiltonianOptions& opts)
+{
+    HamiltonianEquivResult out;
+
+    int N = modes.N;
+    if (N == 0) return out;
+    out.N = N;
 
-        out.mu_ex[k] = Vec3{ mx, my, mz };
+    std::vector<double> M;
+    set_site_properties(out, modes, opts.keep_site_properties, M);
+
+    if (opts.lanczos_steps > 0) {
+        lanczos_excitons(out, modes, M, opts);
+        return out;
     }
 
-    for (int k = 0; k < N; ++k) {
-        std::array<double, 9> acc{};
-        for (int t = 0; t < 9; ++t) acc[t] = 0.0;
+    //build hamiltonian
+    std::vector<double> H;
+    build_hamiltonian(modes, M, modes.freq.data(), opts.coupling, H);
 
-        for (int i = 0; i < N; ++i) {
-            double vik = out.Sort_V[i * N + k];
+    // Symmetric oligomer: diagonalize the SFG-active irreps only
+    if (opts.symmetry && opts.symmetry->n > 1) {
+        std::vector<double> Hb, Mb, evals;
+        out.N = cn_sfg_blocks(*opts.symmetry, H, M, Hb, Mb);
 
-            for (int t = 0; t < 9; ++t) {
-                acc[t] += vik * out.alpha_rot[i][t];
-            }
+        if (!diagonalize(Hb, out.N, evals)) {
+            std::cerr << "[Hamiltonian_equiv_matlab] LAPACK dsyev failed\n";
+            return out;
         }
+        set_exciton_properties(out, Hb, evals, Mb, false);
+        return out;
+    }
 
-        out.alpha_ex[k] = acc;
+    // Diagonalize H → eigenvalues + eigenvectors
+    // H is overwritten with eigenvectors (rows) by LAPACKE_dsyev
+    std::vector<double> evals;
+    if (!diagonalize(H, N, evals)) {
+        std::cerr << "[Hamiltonian_equiv_matlab] LAPACK dsyev failed\n";
+        return out;
+    }
+
+    set_exciton_properties(out, H, evals, M, opts.keep_eigenvectors);
+
+    return out;
+}
+
+
+// Matrices diagonalized together by one batched Jacobi call: enough for
+// wide SIMD over the batch, few enough that A and V stay in cache
+static int batch_chunk(int N)
+{
+    return std::max(8, std::min(256, 16384 / (N * N)));
+}
+
+std::vector<HamiltonianEquivResult> Hamiltonian_equiv_matlab_batch(
+    const std::vector<HamiltonianBatchItem>& items,
+    double tilt_deg,
+    double twist_deg,
+    const HamiltonianOptions& opts)
+{
+    std::vector<HamiltonianEquivResult> out(items.size());
+
+    // group by size: only equal-N matrices can share a batch
+    std::map<int, std::vector<int>> by_size;
+    std::vector<int> large;
+    int N_large = 0;
+    for (int m = 0; m < (int)items.size(); m++) {
+        int N = items[m].modes->N;
+        if (N == 0) continue;
+
+        if (N > BATCHED_EIG_MAX_N) {
+            large.push_back(m);
+            N_large = std::max(N_large, N);
+            continue;
+        }
+        by_size[N].push_back(m);
+    }
+
+    // one dsyev each: workers over the members or threaded BLAS inside,
+    // depending on N (thread_scheduler.hpp)
+    if (!large.empty())
+    {
+        ThreadPlan tp = thread_plan(N_large, large.size());
+        BlasThreads blas(tp.blas);
+
+        #pragma omp parallel for schedule(dynamic) num_threads(tp.outer) if (tp.outer > 1)
+        for (size_t k = 0; k < large.size(); k++) {
+            const int m = large[k];
+            AmideModeTable modes = *items[m].modes;
+            if (items[m].freq) modes.freq = *items[m].freq;
+            out[m] = Hamiltonian_equiv_matlab(modes, tilt_deg, twist_deg, opts);
+        }
+    }
+
+    std::vector<double> H, A, evals, V, ev;
+    std::vector<std::vector<double>> M;
+
+    for (const auto& group : by_size)
+    {
+        const int N = group.first;
+        const std::vector<int>& members = group.second;
+
+        const int chunk = batch_chunk(N);
+
+        for (size_t first = 0; first < members.size(); first += chunk)
+        {
+            const int B = std::min<int>(chunk, members.size() - first);
+            A.assign((size_t)N * N * B, 0.0);
+            M.resize(B);
+
+            // build and interleave: A[(i*N + j)*B + b], upper triangle
+            // (= lower triangle of H)
+            for (int b = 0; b < B; b++) {
+                int m = members[first + b];
+                const HamiltonianBatchItem& item = items[m];
+                out[m].N = N;
+                set_site_properties(out[m], *item.modes,
+                                    opts.keep_site_properties, M[b]);
+                build_hamiltonian(*item.modes, M[b],
+                                  item.freq ? item.freq->data() : item.modes->freq.data(),
+                                  opts.coupling, H);
+
+                for (int i = 0; i < N; i++)
+                    for (int j = i; j < N; j++)
+                        A[(size_t)(i * N + j) * B + b] = H[j * N + i];
+            }
+
+            batched_syev_jacobi(N, B, A, evals);
+
+            // de-interleave eigenpairs (eigenvector columns -> rows) and
+            // finish each member
+            ev.resize(N);
+            for (int b = 0; b < B; b++) {
+                V.resize(N * N);
+                for (int i = 0; i < N; i++)
+                    for (int j = 0; j < N; j++)
+                        V[j * N + i] = A[(size_t)(i * N + j) * B + b];
+                for (int k = 0; k < N; k++)
+                    ev[k] = evals[(size_t)k * B + b];
+
+                set_exciton_properties(out[members[first + b]], V, ev, M[b],
+                                       opts.keep_eigenvectors);
+            }
+        }
     }
 
     return out;
@@ -0,0 +1,158 @@
+#include "hamiltonian_lanczos.hpp"
+#include "dipole_tree.hpp"
+
+#include <algorithm>
+#include <cblas.h>
+#include <cmath>
+#include <iostream>
+#include <lapacke.h>
+
+
+static const int SITE_NCOL = 12;
+
+// A new basis vector is kept only if this fraction of its norm survives
+// orthogonalization against the basis (otherwise the block deflates)
+static const double LANCZOS_DEFLATION_TOL = 1e-10;
+
+
+// Orthogonalize v against the first k basis rows Q (k×N) twice (CGS2 via
+// BLAS-2), accumulating the coefficients into h (size k)
+static void orthogonalize(const std::vector<double>& Q, int k, int N,
+                          double* v, double* h, std::vector<double>& tmp)
+{
+    if (k == 0) return;
+    tmp.resize(k);
+
+    for (int pass = 0; pass < 2; pass++) {
+        cblas_dgemv(CblasRowMajor, CblasNoTrans, k, N,
+                    1.0, Q.data(), N, v, 1, 0.0, tmp.data(), 1);
+        cblas_dgemv(CblasRowMajor, CblasTrans, k, N,
+                    -1.0, Q.data(), N, tmp.data(), 1, 1.0, v, 1);
+        if (h)
+            for (int l = 0; l < k; l++) h[l] += tmp[l];
+    }
+}
+
+
+int lanczos_exciton_moments(
+    const DipoleSitesSoA& sites,
+    const std::vector<double>& site_freq,
+    const std::vector<double>& M,
+    double prefactor,
+    double theta,
+    int block_steps,
+    std::vector<double>& ritz,
+    std::vector<double>& E)
+{
+    const int N = static_cast<int>(site_freq.size());
+    const int kmax = std::min(N, SITE_NCOL * std::max(1, block_steps));
+
+    ritz.clear();
+    E.clear();
+    if (N == 0) return 0;
+
+    DipoleTreeOperator J(sites, prefactor, theta);
+
+    // basis rows Q, projected matrix T and start coefficients C (Q0' C = M)
+    std::vector<double> Q((size_t)kmax * N);
+    std::vector<double> T((size_t)kmax * kmax, 0.0);
+    std::vector<double> C((size_t)SITE_NCOL * SITE_NCOL, 0.0);
+    std::vector<double> v(N), tmp, h(kmax);
+
+    int nq = 0;
+
+    // ---- start block: orthonormal basis of the columns of M ----
+    for (int c = 0; c < SITE_NCOL; c++) {
+        for (int i = 0; i < N; i++) v[i] = M[(size_t)i * SITE_NCOL + c];
+        double norm0 = cblas_dnrm2(N, v.data(), 1);
+        if (norm0 == 0.0) continue;
+
+        std::fill(h.begin(), h.end(), 0.0);
+        orthogonalize(Q, nq, N, v.data(), h.data(), tmp);
+        for (int l = 0; l < nq; l++) C[(size_t)l * SITE_NCOL + c] = h[l];
+
+        double nrm = cblas_dnrm2(N, v.data(), 1);
+        if (nrm <= LANCZOS_DEFLATION_TOL * norm0) continue;
+
+        C[(size_t)nq * SITE_NCOL + c] = nrm;
+        cblas_dcopy(N, v.data(), 1, &Q[(size_t)nq * N], 1);
+        cblas_dscal(N, 1.0 / nrm, &Q[(size_t)nq * N], 1);
+        nq++;
+    }
+    const int r0 = nq;
+    if (r0 == 0) return 0;
+
+    // ---- block Lanczos with full reorthogonalization ----
+    // Block [b0, b1) is multiplied by H; its residuals, orthogonalized
+    // against everything, become the next block. T(l, j) for l >= b1 is
+    // the residual norm / coefficient, everything else comes from h.
+    int b0 = 0, b1 = nq;
+    std::vector<double> R;
+
+    while (b0 < b1)
+    {
+        const int bs = b1 - b0;
+        R.resize((size_t)bs * N);
+
+        for (int j = b0; j < b1; j++) {
+            const double* q = &Q[(size_t)j * N];
+            double* w = &R[(size_t)(j - b0) * N];
+
+            J.apply(q, w);
+            for (int i = 0; i < N; i++) w[i] += site_freq[i] * q[i];
+
+            std::fill(h.begin(), h.end(), 0.0);
+            orthogonalize(Q, b1, N, w, h.data(), tmp);
+            for (int l = 0; l < b1; l++) T[(size_t)l * kmax + j] = h[l];
+        }
+
+        if (b1 == kmax) break;
+
+        // residual block -> new basis vectors (deflating dependent ones)
+        for (int j = b0; j < b1; j++) {
+            double* w = &R[(size_t)(j - b0) * N];
+            double norm0 = std::fabs(T[(size_t)j * kmax + j]) + cblas_dnrm2(N, w, 1);
+
+            std::fill(h.begin(), h.end(), 0.0);
+            orthogonalize(Q, nq, N, w, h.data(), tmp);
+            for (int l = b1; l < nq; l++) T[(size_t)l * kmax + j] = h[l];
+
+            double nrm = cblas_dnrm2(N, w, 1);
+            if (nrm <= LANCZOS_DEFLATION_TOL * norm0 || nq >= kmax) continue;
+
+            T[(size_t)nq * kmax + j] = nrm;
+            cblas_dcopy(N, w, 1, &Q[(size_t)nq * N], 1);
+            cblas_dscal(N, 1.0 / nrm, &Q[(size_t)nq * N], 1);
+            nq++;
+        }
+
+        b0 = b1;
+        b1 = nq;
+    }
+
+    // Rayleigh–Ritz on the basis (every block has been multiplied by H)
+    const int K = b1;
+
+    std::vector<double> Tk((size_t)K * K);
+    for (int i = 0; i < K; i++)
+        for (int j = 0; j < K; j++)
+            Tk[(size_t)i * K + j] = 0.5 * (T[(size_t)i * kmax + j] + T[(size_t)j * kmax + i]);
+
+    ritz.resize(K);
+    int info = LAPACKE_dsyev(LAPACK_COL_MAJOR, 'V', 'U', K, Tk.data(), K, ritz.data());
+    if (info != 0) {
+        std::cerr << "[lanczos_exciton_moments] LAPACK dsyev failed\n";
+        ritz.clear();
+        return 0;
+    }
+
+    // moments of Ritz vector l: sum_a Z(a, l) C(a, :), a over the start
+    // block (eigenvector l is row l of Tk)
+    E.assign((size_t)K * SITE_NCOL, 0.0);
+    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                K, SITE_NCOL, r0,
+                1.0, Tk.data(), K, C.data(), SITE_NCOL,
+                0.0, E.data(), SITE_NCOL);
+
+    return K;
+}
@@ -1,4 +1,5 @@
 #include "initialize_amideI_frequency.hpp"
+#include <random>
 
 std::vector<AmideIFreq> initialize_amideI_frequency(
     std::size_t n_modes,
@@ -17,3 +18,21 @@ std::vector<AmideIFreq> initialize_amideI_frequency(
 
     return freq_list;
 }
+
+std::vector<std::vector<double>> make_disorder_ensemble(
+    const std::vector<double>& freq,
+    double sigma,
+    int n_samples,
+    unsigned seed)
+{
+    std::vector<std::vector<double>> ensemble(n_samples, freq);
+
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> shift(0.0, sigma);
+
+    for(auto& sample : ensemble)
+        for(double& fi : sample)
+            fi += shift(rng);
+
+    return ensemble;
+}
@@ -0,0 +1,102 @@
+#include "lattice_sum.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+// Lattice vectors n1 a + n2 b with 0 < |L| < cutoff (SoA); L and -L both
+// appear, so the sum over them is symmetric in (i, j)
+static void lattice_points(const Lattice2D& lat,
+                           std::vector<double>& Lx,
+                           std::vector<double>& Ly,
+                           std::vector<double>& Lz)
+{
+    const double area = norm(cross(lat.a, lat.b));
+    const double rc2  = lat.cutoff * lat.cutoff;
+
+    // |n1| <= cutoff * |b| / area bounds every lattice point inside the circle
+    const int n1max = static_cast<int>(lat.cutoff * norm(lat.b) / area) + 1;
+    const int n2max = static_cast<int>(lat.cutoff * norm(lat.a) / area) + 1;
+
+    for (int n1 = -n1max; n1 <= n1max; n1++)
+        for (int n2 = -n2max; n2 <= n2max; n2++) {
+            if (n1 == 0 && n2 == 0) continue;
+            Vec3 L = lat.a * n1 + lat.b * n2;
+            if (dot(L, L) >= rc2) continue;
+            Lx.push_back(L.x);
+            Ly.push_back(L.y);
+            Lz.push_back(L.z);
+        }
+}
+
+
+void build_periodic_dipole_coupling_matrix(
+    const DipoleSitesSoA& s,
+    double prefactor,
+    const Lattice2D& lat,
+    double* H,
+    int N)
+{
+    // home cell (L = 0, j < i) exactly as the finite system
+    build_dipole_coupling_matrix(s, prefactor, H, N);
+
+    std::vector<double> Lx, Ly, Lz;
+    lattice_points(lat, Lx, Ly, Lz);
+    const int nL = static_cast<int>(Lx.size());
+
+    // continuum tail beyond the cutoff: pi / (A rc) (3 n n' - 1)
+    Vec3 nrm = cross(lat.a, lat.b);
+    const double area = norm(nrm);
+    nrm = nrm / area;
+    const double tail = M_PI / (area * lat.cutoff);
+
+    const double* Px = Lx.data();
+    const double* Py = Ly.data();
+    const double* Pz = Lz.data();
+
+    #pragma omp parallel for schedule(dynamic, 4) if (N >= 64)
+    for (int i = N - 1; i >= 0; i--)
+    {
+        const Vec3 mi = { s.mux[i], s.muy[i], s.muz[i] };
+        double* row = H + (size_t)i * N;
+
+        for (int j = 0; j <= i; j++)
+        {
+            const Vec3 mj = { s.mux[j], s.muy[j], s.muz[j] };
+            const double dx = s.x[i] - s.x[j];
+            const double dy = s.y[i] - s.y[j];
+            const double dz = s.z[i] - s.z[j];
+            const double mix = mi.x, miy = mi.y, miz = mi.z;
+            const double mjx = mj.x, mjy = mj.y, mjz = mj.z;
+            const double mimj = dot(mi, mj);
+
+            auto image_sum = [&](bool skip_overlap) {
+                double acc = 0.0;
+
+                #pragma omp simd reduction(+:acc)
+                for (int l = 0; l < nL; l++)
+                {
+                    double rx = dx + Px[l], ry = dy + Py[l], rz = dz + Pz[l];
+                    double R2 = rx * rx + ry * ry + rz * rz;
+                    double r  = rsqrt_newton(R2);
+                    double inv2 = r * r;
+
+                    double ri = rx * mix + ry * miy + rz * miz;
+                    double rj = rx * mjx + ry * mjy + rz * mjz;
+                    double J  = inv2 * r * (mimj - 3.0 * ri * rj * inv2);
+                    if (skip_overlap && R2 == 0.0) J = 0.0;
+                    acc += J;
+                }
+                return acc;
+            };
+
+            // an image on top of a site does not couple (as R = 0); that
+            // case is rare enough to get its own (non-vectorized) pass
+            double acc = image_sum(false);
+            if (!std::isfinite(acc)) acc = image_sum(true);
+
+            acc += tail * (3.0 * dot(mi, nrm) * dot(mj, nrm) - mimj);
+            row[j] += prefactor * acc;
+        }
+    }
+}
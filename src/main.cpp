@@ -3,6 +3,7 @@
 #include <iomanip>
 #include <vector>
 #include <filesystem>
+#include <memory>
 #include <omp.h>
 
 #include "Read_Input.hpp"
@@ -10,19 +11,65 @@
 #include "Fresnel_Calculation.hpp"   // optional
 #include "generate_angles.hpp"
 
-#include "get_amideI_multi.hpp"
-#include "hamiltonian_equiv_matlab.hpp"
 #include "chi2_matlab.hpp"
 #include "load_R3ZXZ1.hpp"
-#include "compute_SFG_spectra.hpp"
+#include "run_trajectory.hpp"
+#include "sfg_session.hpp"
+#include "sfg_daemon.hpp"
+#include "batch_driver.hpp"
+#include "mpi_driver.hpp"
+#include "thread_scheduler.hpp"
 
 
-int main()
+int main(int argc, char** argv)
 {
+#ifdef SFG_USE_MPI
+    // sfg_simulator_mpi: orientation grid or batch manifest split over ranks
+    return run_mpi(argc, argv);
+#endif
+
+    // sfg_simulator --daemon <socket> [cache_MB]: local spectrum service
+    if (argc > 1 && std::string(argv[1]) == "--daemon")
+    {
+        if (argc < 3) {
+            std::cerr << "usage: " << argv[0] << " --daemon <socket> [cache_MB]\n";
+            return 1;
+        }
+        DaemonOptions opts;
+        opts.socket_path = argv[2];
+        if (argc > 3) opts.cache_bytes = (size_t)std::stoul(argv[3]) << 20;
+        return run_sfg_daemon(opts);
+    }
+
+    // sfg_simulator --tune-threads: OpenMP/BLAS crossover of this machine
+    if (argc > 1 && std::string(argv[1]) == "--tune-threads")
+    {
+        omp_set_dynamic(0);
+        tune_blas_crossover(std::cout);
+        return 0;
+    }
+
+    // sfg_simulator --batch <manifest> [threads]: many structures, one pool
+    if (argc > 1 && std::string(argv[1]) == "--batch")
+    {
+        if (argc < 3) {
+            std::cerr << "usage: " << argv[0] << " --batch <manifest> [threads]\n";
+            return 1;
+        }
+        int threads = argc > 3 ? std::stoi(argv[3]) : omp_get_max_threads();
+        return run_batch(argv[2], threads);
+    }
+
     std::cout << "=== FULL Amide-I + SFG Pipeline (MATLAB Equivalent) ===\n";
     omp_set_dynamic(0);
 
-    InputParams in = Read_Input("./input/input.txt");
+    InputParams in;
+    try {
+        in = Read_Input("./input/input.txt");
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << "\n";
+        exit(1);
+    }
 
     std::cout << "PDB: " << in.pdbFile << "\n";
     std::cout << "Center Freq: " << in.centerFreq << "\n";
@@ -34,126 +81,122 @@ int main()
               << " (" << in.twist_points << " points)\n";
 
     std::filesystem::create_directories(in.SpectraFolder);
+    if (in.debug_output)
+        std::filesystem::create_directories("debug1");
 
+    // Generate tilt/twist vectors (same as old MATLAB driver)
+    auto tilt_vec  = Linspace(in.tilt_start,  in.tilt_end,  in.tilt_points);
+    auto twist_vec = Linspace(in.twist_start, in.twist_end, in.twist_points);
 
-    std::vector<double> freq_grid;
-    for (double w = in.spec_range_start; w <= in.spec_range_end; w += in.spec_range_step)
-        freq_grid.push_back(w);
-
-
-    AmideIMultiOutput M =
-        Get_AmideI_Multi(in.centerFreq, 1, 5, in.layer, in.pdbFile);
-
-    int N = M.center.size();
-    std::cout << "Total modes = " << N << "\n";
-
-    // Prepare Hamiltonian input arrays
-    std::vector<AmideIGeo>  geo(N);
-    std::vector<AmideIProps> props(N);
-    std::vector<AmideIFreq> freqs(N);
 
-    for (int i = 0; i < N; i++)
+    // Multi-model trajectory: streamed frame by frame
+    if (in.trajectory)
     {
-        geo[i].vibration_center_coord = M.center[i];
-        props[i].dipole_sim           = M.mu_orig[i];
+        // χ elements to evaluate; all 27 only for the debug dumps
+        Chi2Plan plan;
+        if (!make_chi2_plan(in.sfg_elements, in.debug_output, plan))
+            exit(1);
+
+        std::vector<double> freq_grid;
+        for (double w = in.spec_range_start; w <= in.spec_range_end; w += in.spec_range_step)
+            freq_grid.push_back(w);
+
+        // the R3 table is only opened for r3_source = database
+        std::unique_ptr<R3Database> Rdb;
+        if (in.r3_source == "database")
+            Rdb.reset(new R3Database("./data/R3ZXZ1_database.h5"));
+
+        try {
+            run_trajectory_pipeline(in, plan, freq_grid, tilt_vec, twist_vec, Rdb.get());
+        } catch (const std::exception& e) {
+            std::cerr << "ERROR: " << e.what() << "\n";
+            exit(1);
+        }
+        std::cout << "\n=== Completed trajectory SFG pipeline ===\n";
+        return 0;
+    }
 
-        for (int r = 0; r < 3; r++)
-            for (int c = 0; c < 3; c++)
-                props[i].alpha_matrix[r][c] = M.alpha_matrix[i][r*3 + c];
 
-        freqs[i].freq = M.freq[i];
+    // Static structure: parsed and solved once, then every orientation
+    std::unique_ptr<SFGSession> session;
+    try {
+        session.reset(new SFGSession(in, nullptr, true));
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << "\n";
+        exit(1);
     }
 
+    const int nTilt  = tilt_vec.size();
+    const int nAng   = twist_vec.size() * nTilt;
+    const int nsel   = session->n_elements();
+    const size_t nf  = session->n_freq();
+    const auto& freq = session->freq_grid();
 
-    R3Database Rdb("./data/R3ZXZ1_database.h5");
+    std::string header = "# freq";
+    for (const auto& l : session->plan().labels) header += "   " + l;
 
-    // Generate tilt/twist vectors (same as old MATLAB driver)
-    auto tilt_vec  = Linspace(in.tilt_start,  in.tilt_end,  in.tilt_points);
-    auto twist_vec = Linspace(in.twist_start, in.twist_end, in.twist_points);
+    std::vector<double> I((size_t)nAng * nsel * nf);
+    session->sweep(tilt_vec, twist_vec, I.data());
 
 
-    #pragma omp parallel for collapse(2) schedule(dynamic)
-    for (int it = 0; it < (int)twist_vec.size(); it++)
+    #pragma omp parallel for schedule(dynamic)
+    for (int a = 0; a < nAng; a++)
     {
-        for (int jt = 0; jt < (int)tilt_vec.size(); jt++)
+        double twist_deg = twist_vec[a / nTilt];
+        double tilt_deg  = tilt_vec[a % nTilt];
+
+        std::string tag =
+            "tilt" + std::to_string((int)std::round(tilt_deg)) +
+            "_twist" + std::to_string((int)std::round(twist_deg));
+
+        // DEBUG OUTPUT (thread safe, debug_output = yes)
+        if (in.debug_output)
         {
-            double twist_deg = twist_vec[it];
-            double tilt_deg  = tilt_vec[jt];
+            Chi2Result chi = session->chi2(tilt_deg, twist_deg);
 
-            // Each thread prints independently → optional mutex if needed
-            #pragma omp critical
-            {
-                std::cout << "\n>>> tilt = " << tilt_deg
-                        << "°, twist = " << twist_deg << "°\n";
-            }
+            std::ofstream fmol("debug1/chi_mol_" + tag + ".txt");
+            std::ofstream flab("debug1/chi_lab_" + tag + ".txt");
 
-            // Exciton 
-            HamiltonianEquivResult H =
-                Hamiltonian_equiv_matlab(geo, props, freqs, tilt_deg, twist_deg);
+            if (fmol && flab)
+            {
+                fmol << std::setprecision(10);
+                flab << std::setprecision(10);
 
-            
-            // chi2 using R3 lookup
-            R3Matrix R = Rdb.get_R(twist_deg, tilt_deg);
+                for (int k = 0; k < chi.N; k++) {
+                    fmol << "# exciton " << k << "\n";
+                    flab << "# exciton " << k << "\n";
 
-            Chi2Result chi = compute_chi2_matlab(H, R);
+                    for (int i = 0; i < 27; i++)
+                        fmol << chi.chi_mol[k][i] << (i == 26 ? '\n' : ' ');
 
-            
-            // DEBUG OUTPUT (thread safe)
-            {
-                std::string tag =
-                    "tilt" + std::to_string((int)std::round(tilt_deg)) +
-                    "_twist" + std::to_string((int)std::round(twist_deg));
-
-                {
-                    std::ofstream fmol("debug1/chi_mol_" + tag + ".txt");
-                    std::ofstream flab("debug1/chi_lab_" + tag + ".txt");
-
-                    if (fmol && flab)
-                    {
-                        fmol << std::setprecision(10);
-                        flab << std::setprecision(10);
-
-                        for (int k = 0; k < chi.N; k++) {
-                            fmol << "# exciton " << k << "\n";
-                            flab << "# exciton " << k << "\n";
-
-                            for (int i = 0; i < 27; i++)
-                                fmol << chi.chi_mol[k][i] << (i == 26 ? '\n' : ' ');
-
-                            for (int i = 0; i < 27; i++)
-                                flab << chi.chi_lab[k][i] << (i == 26 ? '\n' : ' ');
-                        }
-                    }
+                    for (int i = 0; i < 27; i++)
+                        flab << chi.chi_lab[k][i] << (i == 26 ? '\n' : ' ');
                 }
             }
+        }
 
-            SpectrumResult spec =
-                compute_SFG_spectra(H, chi, in.width, freq_grid);
 
+        {
+            std::string fname =
+                in.SpectraFolder + "/" +
+                in.SpectraStorePrefix + "_" + tag + ".txt";
+
+            std::ofstream fout(fname);
+            fout << header << "\n";
+            fout << std::setprecision(10);
 
+            const double* Ia = &I[(size_t)a * nsel * nf];
+            for (size_t i = 0; i < nf; i++)
             {
-                std::string fname =
-                    in.SpectraFolder + "/" +
-                    in.SpectraStorePrefix +
-                    "_tilt"  + std::to_string((int)std::round(tilt_deg)) +
-                    "_twist" + std::to_string((int)std::round(twist_deg)) +
-                    ".txt";
-
-                std::ofstream fout(fname);
-                fout << "# freq   SSP(yyz)   PPP(zzz)\n";
-                fout << std::setprecision(10);
-
-                for (size_t i = 0; i < spec.freq.size(); i++)
-                {
-                    fout << spec.freq[i] << " "
-                        << spec.I_ssp[i] << " "
-                        << spec.I_ppp[i] << "\n";
-                }
+                fout << freq[i];
+                for (int e = 0; e < nsel; e++)
+                    fout << " " << Ia[e * nf + i];
+                fout << "\n";
+            }
 
-                #pragma omp critical
-                {
-                    std::cout << "Wrote: " << fname << "\n";
-                }
+            #pragma omp critical
+            {
+                std::cout << "Wrote: " << fname << "\n";
             }
         }
     }
@@ -0,0 +1,34 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+MappedFile::~MappedFile()
+{
+    if (ptr) munmap(const_cast<char*>(ptr), len);
+}
+
+
+bool MappedFile::open(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+
+    len = static_cast<std::size_t>(st.st_size);
+    if (len > 0) {
+        void* p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) { ::close(fd); len = 0; return false; }
+        madvise(p, len, MADV_SEQUENTIAL);
+        ptr = static_cast<const char*>(p);
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+    return true;
+}
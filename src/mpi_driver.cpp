@@ -0,0 +1,319 @@
+// Only compiled into sfg_simulator_mpi (make mpi); empty in libsfg
+#ifdef SFG_USE_MPI
+
+#include "mpi_driver.hpp"
+#include "batch_driver.hpp"
+#include "sfg_session.hpp"
+#include "load_R3ZXZ1.hpp"
+#include "generate_angles.hpp"
+#include "thread_scheduler.hpp"
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+
+static int mpi_rank()
+{
+    int r;
+    MPI_Comm_rank(MPI_COMM_WORLD, &r);
+    return r;
+}
+
+static int mpi_size()
+{
+    int n;
+    MPI_Comm_size(MPI_COMM_WORLD, &n);
+    return n;
+}
+
+// true on every rank iff ok on every rank (keeps the collectives in step)
+static bool all_ok(bool ok)
+{
+    int v = ok ? 1 : 0, all = 0;
+    MPI_Allreduce(&v, &all, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    return all == 1;
+}
+
+
+// -----------------------------------------------------------------------------
+// Collective output
+// -----------------------------------------------------------------------------
+
+// buf holds this rank's blocks back to back; block k goes to byte disp[k]
+// of fname. One MPI_File_write_all over a file view of those ranges.
+static bool write_blocks(const std::string& fname, const std::string& buf,
+                         const std::vector<MPI_Aint>& disp, const std::vector<int>& len)
+{
+    if (buf.size() > (size_t)std::numeric_limits<int>::max())
+        throw std::runtime_error("more than 2 GB of output on one rank");
+
+    MPI_File fh;
+    int rc = MPI_File_open(MPI_COMM_WORLD, fname.c_str(),
+                           MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh);
+    if (rc != MPI_SUCCESS) {
+        if (mpi_rank() == 0) std::cerr << "ERROR: cannot open " << fname << "\n";
+        return false;
+    }
+    MPI_File_set_size(fh, 0);       // drop a longer previous file
+
+    MPI_Datatype filetype = MPI_CHAR;
+    if (!disp.empty()) {
+        MPI_Type_create_hindexed(disp.size(), len.data(), disp.data(), MPI_CHAR, &filetype);
+        MPI_Type_commit(&filetype);
+    }
+    MPI_File_set_view(fh, 0, MPI_CHAR, filetype, "native", MPI_INFO_NULL);
+    MPI_File_write_all(fh, buf.data(), (int)buf.size(), MPI_CHAR, MPI_STATUS_IGNORE);
+
+    if (filetype != MPI_CHAR) MPI_Type_free(&filetype);
+    MPI_File_close(&fh);
+    return true;
+}
+
+static std::string column_header(const SFGSession& s)
+{
+    std::string h = "# tilt twist freq";
+    for (const auto& l : s.plan().labels) h += "   " + l;
+    return h + "\n";
+}
+
+// Rows of orientations a0 … a1-1, I[(a - a0) * nsel * nf …]
+static void append_rows(std::string& out, const SFGSession& s,
+                        const std::vector<double>& tilt, const std::vector<double>& twist,
+                        int a0, int a1, const double* I)
+{
+    const int nTilt = tilt.size();
+    const int nsel  = s.n_elements();
+    const size_t nf = s.n_freq();
+
+    std::ostringstream os;
+    os << std::setprecision(10);
+    for (int a = a0; a < a1; a++) {
+        const double* Ia = I + (size_t)(a - a0) * nsel * nf;
+        for (size_t i = 0; i < nf; i++) {
+            os << tilt[a % nTilt] << " " << twist[a / nTilt] << " " << s.freq_grid()[i];
+            for (int e = 0; e < nsel; e++) os << " " << Ia[e * nf + i];
+            os << "\n";
+        }
+    }
+    out += os.str();
+}
+
+
+// -----------------------------------------------------------------------------
+// Orientation sweep of one structure
+// -----------------------------------------------------------------------------
+static int mpi_sweep(const std::string& input_file)
+{
+    const int rank = mpi_rank(), size = mpi_size();
+
+    std::unique_ptr<SFGSession> session;
+    std::string err;
+    try {
+        InputParams in = Read_Input(input_file);
+        if (in.trajectory)
+            throw std::runtime_error("trajectory input is not supported by the MPI build");
+        session.reset(new SFGSession(in, nullptr, rank == 0));
+    } catch (const std::exception& e) {
+        err = e.what();
+    }
+    if (!all_ok(err.empty())) {
+        if (!err.empty() && rank == 0) std::cerr << "ERROR: " << err << "\n";
+        return 1;
+    }
+
+    const SFGSession& s = *session;
+    const InputParams& in = s.input();
+    auto tilt  = Linspace(in.tilt_start,  in.tilt_end,  in.tilt_points);
+    auto twist = Linspace(in.twist_start, in.twist_end, in.twist_points);
+
+    // contiguous block of the twist-major grid
+    const int nTilt = tilt.size();
+    const int nAng  = twist.size() * nTilt;
+    const int a0 = (int)((long long)nAng * rank / size);
+    const int a1 = (int)((long long)nAng * (rank + 1) / size);
+    const size_t len = (size_t)s.n_elements() * s.n_freq();
+
+    std::vector<double> I((size_t)(a1 - a0) * len);
+    BlasThreads blas(1);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int a = a0; a < a1; a++)
+        s.spectrum(tilt[a % nTilt], twist[a / nTilt], &I[(a - a0) * len]);
+
+    std::string buf = rank == 0 ? column_header(s) : std::string();
+    append_rows(buf, s, tilt, twist, a0, a1, I.data());
+
+    // blocks are in rank order: offset = bytes of the lower ranks
+    long long bytes = buf.size(), offset = 0;
+    MPI_Exscan(&bytes, &offset, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (rank == 0) offset = 0;
+
+    std::string fname = in.SpectraFolder + "/" + in.SpectraStorePrefix + "_sweep.txt";
+    if (rank == 0) std::filesystem::create_directories(in.SpectraFolder);
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    std::vector<MPI_Aint> disp;
+    std::vector<int> blen;
+    if (!buf.empty()) { disp.push_back(offset); blen.push_back(buf.size()); }
+    if (!write_blocks(fname, buf, disp, blen)) return 1;
+
+    if (rank == 0)
+        std::cout << "Wrote: " << fname << " (" << nAng << " orientations, "
+                  << size << " ranks)\n";
+    return 0;
+}
+
+
+// -----------------------------------------------------------------------------
+// Structure manifest
+// -----------------------------------------------------------------------------
+static int mpi_batch(const std::string& manifest, const std::string& out_file)
+{
+    const int rank = mpi_rank(), size = mpi_size();
+
+    std::vector<BatchJob> jobs;
+    std::string err;
+    try {
+        jobs = read_batch_manifest(manifest);
+    } catch (const std::exception& e) {
+        err = e.what();
+    }
+    if (!all_ok(err.empty())) {
+        if (rank == 0) std::cerr << "ERROR: " << err << "\n";
+        return 1;
+    }
+
+    // every rank reads every input: cheap, and the assignment below must be
+    // the same everywhere
+    const int nj = jobs.size();
+    std::vector<InputParams> in(nj);
+    std::vector<std::string> job_err(nj);
+    std::vector<double> cost(nj, 0.0);
+
+    for (int j = 0; j < nj; j++) {
+        try {
+            in[j] = read_batch_job(jobs[j]);
+            std::error_code ec;
+            double pdb = (double)std::filesystem::file_size(in[j].pdbFile, ec);
+            cost[j] = (ec ? 1.0 : pdb) * in[j].tilt_points * in[j].twist_points *
+                      std::max(1, in[j].disorder_samples);
+        } catch (const std::exception& e) {
+            job_err[j] = e.what();
+        }
+    }
+
+    // largest job first to the least loaded rank
+    std::vector<int> order(nj), owner(nj);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](int a, int b) { return cost[a] > cost[b]; });
+    std::vector<double> load(size, 0.0);
+    for (int j : order) {
+        int r = std::min_element(load.begin(), load.end()) - load.begin();
+        owner[j] = r;
+        load[r] += cost[j];
+    }
+
+    // own jobs, in manifest order
+    std::string buf;
+    std::vector<long long> block(nj, 0);
+    int failed = 0;
+    std::shared_ptr<R3Database> Rdb;    // opened on this rank's first database job
+
+    for (int j = 0; j < nj; j++)
+    {
+        if (owner[j] != rank) continue;
+        const size_t start = buf.size();
+
+        buf += "# job " + std::to_string(jobs[j].line) + " " + jobs[j].input_file;
+        try {
+            if (!job_err[j].empty()) throw std::runtime_error(job_err[j]);
+            in[j].debug_output = false;
+            buf += " " + in[j].SpectraFolder + "/" + in[j].SpectraStorePrefix + "\n";
+
+            if (in[j].r3_source == "database" && !Rdb) {
+                try {
+                    Rdb = std::make_shared<R3Database>("./data/R3ZXZ1_database.h5");
+                } catch (const H5::Exception& e) {
+                    throw std::runtime_error("Cannot open R3 table "
+                                             "./data/R3ZXZ1_database.h5: " + e.getDetailMsg());
+                }
+            }
+            SFGSession s(in[j], Rdb);
+
+            auto tilt  = Linspace(in[j].tilt_start,  in[j].tilt_end,  in[j].tilt_points);
+            auto twist = Linspace(in[j].twist_start, in[j].twist_end, in[j].twist_points);
+            std::vector<double> I(tilt.size() * twist.size() * s.n_elements() * s.n_freq());
+            s.sweep(tilt, twist, I.data());
+
+            buf += column_header(s);
+            append_rows(buf, s, tilt, twist, 0, tilt.size() * twist.size(), I.data());
+        } catch (const std::exception& e) {
+            if (buf.back() != '\n') buf += "\n";
+            std::string msg = e.what();
+            std::replace(msg.begin(), msg.end(), '\n', ' ');
+            buf += "# ERROR " + msg + "\n";
+            std::cerr << "ERROR: manifest line " << jobs[j].line << " ("
+                      << jobs[j].input_file << "): " << msg << "\n";
+            failed++;
+        }
+        block[j] = buf.size() - start;
+    }
+
+    // every block size on every rank -> offsets in manifest order
+    MPI_Allreduce(MPI_IN_PLACE, block.data(), nj, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+    std::vector<MPI_Aint> disp;
+    std::vector<int> blen;
+    long long off = 0;
+    for (int j = 0; j < nj; j++) {
+        if (owner[j] == rank && block[j] > 0) {
+            disp.push_back(off);
+            blen.push_back(block[j]);
+        }
+        off += block[j];
+    }
+    if (!write_blocks(out_file, buf, disp, blen)) return 1;
+
+    MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    if (rank == 0)
+        std::cout << "Wrote: " << out_file << " (" << nj << " jobs, " << failed
+                  << " failed, " << size << " ranks)\n";
+    return failed > 0 ? 1 : 0;
+}
+
+
+int run_mpi(int argc, char** argv)
+{
+    // MPI is only called from the main thread; OpenMP runs inside each rank
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+
+    int rc;
+    if (argc > 1 && std::string(argv[1]) == "--batch") {
+        if (argc < 3) {
+            if (mpi_rank() == 0)
+                std::cerr << "usage: " << argv[0] << " --batch <manifest> [output_file]\n";
+            rc = 1;
+        } else {
+            rc = mpi_batch(argv[2], argc > 3 ? argv[3] : "batch_spectra.txt");
+        }
+    } else {
+        rc = mpi_sweep("./input/input.txt");
+    }
+
+    MPI_Finalize();
+    return rc;
+}
+
+#endif
@@ -0,0 +1,229 @@
+#include "run_trajectory.hpp"
+#include "Read_PDB_Trajectory.hpp"
+#include "bounded_queue.hpp"
+#include "get_amideI_multi.hpp"
+#include "hamiltonian_equiv_matlab.hpp"
+#include "chi2_matlab.hpp"
+#include "apply_R3.hpp"
+#include "compute_SFG_spectra.hpp"
+#include "coupling_model.hpp"
+#include "thread_scheduler.hpp"
+
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+
+// One parsed frame, ready for the Hamiltonian stage
+struct FrameSites {
+    int index = 0;
+    AmideModeTable modes;
+};
+
+// Spectra of one frame for every (twist, tilt) pair, twist-major
+struct FrameSpectra {
+    int index = 0;
+    std::vector<SpectrumResult> spec;
+};
+
+// Frames in flight between two stages
+static const std::size_t QUEUE_DEPTH = 2;
+
+
+static std::string angle_tag(double tilt_deg, double twist_deg)
+{
+    return "_tilt"  + std::to_string((int)std::round(tilt_deg)) +
+           "_twist" + std::to_string((int)std::round(twist_deg));
+}
+
+
+void run_trajectory_pipeline(
+    const InputParams& in,
+    const Chi2Plan& plan,
+    const std::vector<double>& freq_grid,
+    const std::vector<double>& tilt_vec,
+    const std::vector<double>& twist_vec,
+    R3Database* Rdb)
+{
+    const int nTwist = twist_vec.size();
+    const int nTilt  = tilt_vec.size();
+    const int nAng   = nTwist * nTilt;
+    const size_t nf  = freq_grid.size();
+    const int nsel   = plan.elements.size();
+
+    std::string header = "# freq";
+    for (const auto& l : plan.labels) header += "   " + l;
+
+    // R3 does not change between frames: set up each orientation once
+    // (the table is only read for r3_source = database)
+    const bool r3_table = (Rdb != nullptr);
+    std::vector<R3Rotation> R(nAng);
+    std::vector<R3Matrix>   Rtab(r3_table ? nAng : 0);
+    for (int it = 0; it < nTwist; it++)
+        for (int jt = 0; jt < nTilt; jt++) {
+            R[it * nTilt + jt] = make_R3_rotation(twist_vec[it], tilt_vec[jt]);
+            if (r3_table)
+                Rtab[it * nTilt + jt] = Rdb->get_R(twist_vec[it], tilt_vec[jt]);
+        }
+
+    std::unique_ptr<CouplingModel> coupling =
+        make_coupling_model(in.coupling_model, in.nn_coupling_map, in.lattice);
+
+    BoundedQueue<FrameSites>   q_sites(QUEUE_DEPTH);
+    BoundedQueue<FrameSpectra> q_spec(QUEUE_DEPTH);
+
+    // ---------------- reader stage ----------------
+    // a bad file or record ends the stream; rethrown after the join
+    std::exception_ptr reader_error;
+    std::thread reader([&]() {
+        try {
+            PDBTrajectoryReader traj(in.pdbFile, !in.freq_map);
+            std::vector<Atom> atoms;
+
+            while (traj.next_frame(atoms))
+            {
+                // chain breaks are reported for the first frame only
+                FrameSites fs;
+                fs.index = traj.frames_read() - 1;
+                fs.modes = Get_AmideI_Multi(in.centerFreq, in.amide_first, in.amide_last,
+                                            in.layer, atoms,
+                                            in.freq_map ? &in.freq_map_params : nullptr,
+                                            traj.frames_read() == 1);
+
+                q_sites.push(std::move(fs));
+            }
+        } catch (...) {
+            reader_error = std::current_exception();
+        }
+        q_sites.close();
+    });
+
+    // ---------------- writer stage ----------------
+    std::thread writer([&]() {
+        std::ofstream fout;
+        if (in.write_frame_spectra) {
+            std::string fname =
+                in.SpectraFolder + "/" + in.SpectraStorePrefix + "_frames.txt";
+            fout.open(fname);
+            fout << "# frame   tilt   twist   " << header.substr(2) << "\n";
+            fout << std::setprecision(10);
+        }
+
+        FrameSpectra fr;
+        while (q_spec.pop(fr))
+        {
+            if (fout) {
+                for (int it = 0; it < nTwist; it++)
+                    for (int jt = 0; jt < nTilt; jt++)
+                    {
+                        const SpectrumResult& s = fr.spec[it * nTilt + jt];
+                        for (size_t i = 0; i < s.freq.size(); i++) {
+                            fout << fr.index     << " "
+                                 << tilt_vec[jt] << " "
+                                 << twist_vec[it] << " "
+                                 << s.freq[i];
+                            for (const auto& I_e : s.I)
+                                fout << " " << I_e[i];
+                            fout << "\n";
+                        }
+                    }
+            }
+
+            #pragma omp critical
+            {
+                std::cout << "[trajectory] frame " << fr.index << " done\n";
+            }
+        }
+    });
+
+    // ---------------- compute stage ----------------
+    // running sums, angle-major then element: sum[(a * nsel + e) * nf + i]
+    std::vector<double> sum((size_t)nAng * nsel * nf, 0.0);
+    int nframes = 0;
+
+    FrameSites fs;
+    while (q_sites.pop(fs))
+    {
+        FrameSpectra fr;
+        fr.index = fs.index;
+        fr.spec.resize(nAng);
+
+        // H does not depend on the orientation (that only enters through
+        // R3): solve it once per frame, then χ and the spectrum per angle
+        HamiltonianOptions opts;
+        opts.coupling = coupling.get();
+        if (in.hamiltonian_solver == "lanczos") {
+            opts.lanczos_steps = in.lanczos_steps;
+            opts.tree_theta    = in.bh_theta;
+        }
+
+        HamiltonianEquivResult H;
+        {
+            // one eigenproblem: threaded BLAS only from the tuned crossover on
+            BlasThreads blas(thread_plan(fs.modes.N, 1).blas);
+            H = Hamiltonian_equiv_matlab(fs.modes, 0.0, 0.0, opts);
+        }
+
+        // the angles are the parallel work; BLAS inside them stays serial
+        BlasThreads blas(1);
+        #pragma omp parallel for schedule(dynamic)
+        for (int a = 0; a < nAng; a++)
+        {
+            Chi2Result chi = r3_table ? compute_chi2_matlab(H, Rtab[a], plan)
+                                      : compute_chi2_matlab(H, R[a], plan);
+
+            fr.spec[a] = compute_SFG_spectra(H, chi, in.width, freq_grid);
+
+            // each angle owns its own slice of the running sums
+            for (int e = 0; e < nsel; e++)
+                for (size_t i = 0; i < fr.spec[a].I[e].size(); i++)
+                    sum[(a * nsel + e) * nf + i] += fr.spec[a].I[e][i];
+        }
+
+        nframes++;
+        q_spec.push(std::move(fr));
+    }
+
+    q_spec.close();
+    reader.join();
+    writer.join();
+
+    if (reader_error)
+        std::rethrow_exception(reader_error);
+    if (nframes == 0)
+        throw std::runtime_error("no frames found in trajectory " + in.pdbFile);
+
+    // ---------------- time-averaged spectra ----------------
+    for (int it = 0; it < nTwist; it++)
+    {
+        for (int jt = 0; jt < nTilt; jt++)
+        {
+            int a = it * nTilt + jt;
+
+            std::string fname =
+                in.SpectraFolder + "/" +
+                in.SpectraStorePrefix +
+                angle_tag(tilt_vec[jt], twist_vec[it]) +
+                ".txt";
+
+            std::ofstream fout(fname);
+            fout << "# time average over " << nframes << " frames\n";
+            fout << header << "\n";
+            fout << std::setprecision(10);
+
+            for (size_t i = 0; i < nf; i++) {
+                fout << freq_grid[i];
+                for (int e = 0; e < nsel; e++)
+                    fout << " " << sum[(a * nsel + e) * nf + i] / nframes;
+                fout << "\n";
+            }
+        }
+    }
+
+    std::cout << "[trajectory] averaged " << nframes << " frames\n";
+}
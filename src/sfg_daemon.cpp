@@ -0,0 +1,379 @@
+#include "sfg_daemon.hpp"
+#include "sfg_session.hpp"
+#include "load_R3ZXZ1.hpp"
+#include "generate_angles.hpp"
+#include "thread_scheduler.hpp"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+// -----------------------------------------------------------------------------
+// LRU cache of sessions
+// -----------------------------------------------------------------------------
+namespace {
+
+using file_time = std::filesystem::file_time_type;
+
+static file_time mtime_of(const std::string& path)
+{
+    std::error_code ec;
+    file_time t = std::filesystem::last_write_time(path, ec);
+    return ec ? file_time::min() : t;
+}
+
+class SessionCache {
+public:
+    explicit SessionCache(std::size_t cap_bytes) : cap_(cap_bytes) {}
+
+    // Session of input_file, built (outside the lock) on a miss or when the
+    // input or PDB file changed since it was built
+    std::shared_ptr<const SFGSession> get(const std::string& input_file)
+    {
+        std::error_code ec;
+        std::string key = std::filesystem::canonical(input_file, ec).string();
+        if (ec) throw std::runtime_error("Cannot open input file: " + input_file);
+
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            for (auto it = lru_.begin(); it != lru_.end(); ++it) {
+                if (it->key != key) continue;
+                if (it->input_time == mtime_of(key) &&
+                    it->pdb_time == mtime_of(it->session->input().pdbFile)) {
+                    lru_.splice(lru_.begin(), lru_, it);
+                    hits_++;
+                    return it->session;
+                }
+                lru_.erase(it);     // stale
+                break;
+            }
+            misses_++;
+        }
+
+        Entry e;
+        e.key        = key;
+        e.input_time = mtime_of(key);
+        InputParams in = Read_Input(key);
+        e.session    = std::make_shared<const SFGSession>(
+            in, in.r3_source == "database" ? r3_table() : nullptr);
+        e.pdb_time   = mtime_of(e.session->input().pdbFile);
+
+        std::lock_guard<std::mutex> lock(m_);
+        for (auto it = lru_.begin(); it != lru_.end(); ++it)
+            if (it->key == key) { lru_.erase(it); break; }   // built concurrently
+        lru_.push_front(e);
+        evict();
+        return e.session;
+    }
+
+    // After a request: the R3 matrices read by it count towards the cap
+    void trim()
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        evict();
+    }
+
+    std::vector<std::string> stats()
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        std::vector<std::string> out;
+        out.push_back("structures " + std::to_string(lru_.size()));
+        out.push_back("bytes " + std::to_string(bytes()));
+        out.push_back("cap " + std::to_string(cap_));
+        out.push_back("hits " + std::to_string(hits_));
+        out.push_back("misses " + std::to_string(misses_));
+        out.push_back("evictions " + std::to_string(evictions_));
+        for (const auto& e : lru_)
+            out.push_back("session " + e.key + " " +
+                          std::to_string(e.session->memory_bytes()));
+        return out;
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        file_time input_time, pdb_time;
+        std::shared_ptr<const SFGSession> session;
+    };
+
+    // One HDF5 table for every session, opened on first use
+    std::shared_ptr<R3Database> r3_table()
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        if (!Rdb_) Rdb_ = std::make_shared<R3Database>("./data/R3ZXZ1_database.h5");
+        return Rdb_;
+    }
+
+    std::size_t bytes() const
+    {
+        std::size_t b = 0;
+        for (const auto& e : lru_) b += e.session->memory_bytes();
+        return b;
+    }
+
+    // Requests in flight keep their shared_ptr; eviction only drops ours
+    void evict()
+    {
+        while (lru_.size() > 1 && bytes() > cap_) {
+            std::cout << "Evicting session: " << lru_.back().key << "\n";
+            lru_.pop_back();
+            evictions_++;
+        }
+    }
+
+    std::mutex m_;
+    std::list<Entry> lru_;     // most recently used first
+    std::size_t cap_;
+    std::size_t hits_ = 0, misses_ = 0, evictions_ = 0;
+    std::shared_ptr<R3Database> Rdb_;
+};
+
+
+// -----------------------------------------------------------------------------
+// Requests
+// -----------------------------------------------------------------------------
+static std::string spectrum_header(const SFGSession& s, const char* lead)
+{
+    std::string h = lead;
+    for (const auto& l : s.plan().labels) h += "   " + l;
+    return h;
+}
+
+static std::vector<std::string> do_spectrum(SessionCache& cache, std::istringstream& args)
+{
+    std::string input;
+    double tilt, twist;
+    if (!(args >> input >> tilt >> twist))
+        throw std::runtime_error("usage: spectrum <input_file> <tilt> <twist>");
+
+    auto s = cache.get(input);
+    const int nsel  = s->n_elements();
+    const size_t nf = s->n_freq();
+
+    std::vector<double> I(nsel * nf);
+    s->spectrum(tilt, twist, I.data());
+
+    std::vector<std::string> out;
+    out.push_back(spectrum_header(*s, "# freq"));
+    for (size_t i = 0; i < nf; i++) {
+        std::ostringstream row;
+        row << std::setprecision(10) << s->freq_grid()[i];
+        for (int e = 0; e < nsel; e++) row << " " << I[e * nf + i];
+        out.push_back(row.str());
+    }
+    return out;
+}
+
+static std::vector<std::string> do_sweep(SessionCache& cache, std::istringstream& args)
+{
+    std::string input;
+    if (!(args >> input))
+        throw std::runtime_error("usage: sweep <input_file>");
+
+    auto s = cache.get(input);
+    const InputParams& in = s->input();
+    auto tilt_vec  = Linspace(in.tilt_start,  in.tilt_end,  in.tilt_points);
+    auto twist_vec = Linspace(in.twist_start, in.twist_end, in.twist_points);
+
+    const int nTilt = tilt_vec.size();
+    const int nAng  = twist_vec.size() * nTilt;
+    const int nsel  = s->n_elements();
+    const size_t nf = s->n_freq();
+
+    std::vector<double> I((size_t)nAng * nsel * nf);
+    s->sweep(tilt_vec, twist_vec, I.data());
+
+    std::vector<std::string> out;
+    out.push_back(spectrum_header(*s, "# tilt twist freq"));
+    for (int a = 0; a < nAng; a++) {
+        const double* Ia = &I[(size_t)a * nsel * nf];
+        for (size_t i = 0; i < nf; i++) {
+            std::ostringstream row;
+            row << std::setprecision(10) << tilt_vec[a % nTilt] << " "
+                << twist_vec[a / nTilt] << " " << s->freq_grid()[i];
+            for (int e = 0; e < nsel; e++) row << " " << Ia[e * nf + i];
+            out.push_back(row.str());
+        }
+    }
+    return out;
+}
+
+
+// -----------------------------------------------------------------------------
+// Connections
+// -----------------------------------------------------------------------------
+static bool send_all(int fd, const std::string& msg)
+{
+    size_t off = 0;
+    while (off < msg.size()) {
+        ssize_t n = ::send(fd, msg.data() + off, msg.size() - off, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        off += n;
+    }
+    return true;
+}
+
+struct Server {
+    SessionCache cache;
+    int listen_fd = -1;
+    std::atomic<bool> stopping{ false };
+
+    std::mutex conn_m;
+    std::condition_variable conn_done;
+    std::set<int> clients;          // open connections, one thread each
+
+    explicit Server(std::size_t cap) : cache(cap) {}
+
+    void stop()
+    {
+        if (stopping.exchange(true)) return;
+        ::shutdown(listen_fd, SHUT_RDWR);           // wakes accept()
+        std::lock_guard<std::mutex> lock(conn_m);
+        for (int fd : clients) ::shutdown(fd, SHUT_RDWR);
+    }
+
+    // Reply to one request line; false ends the connection
+    bool handle(int fd, const std::string& line)
+    {
+        std::istringstream args(line);
+        std::string cmd;
+        args >> cmd;
+        if (cmd.empty()) return true;
+
+        std::vector<std::string> out;
+        try {
+            if (cmd == "spectrum")      out = do_spectrum(cache, args);
+            else if (cmd == "sweep")    out = do_sweep(cache, args);
+            else if (cmd == "stats")    out = cache.stats();
+            else if (cmd == "shutdown") { send_all(fd, "OK 0\n"); stop(); return false; }
+            else throw std::runtime_error("unknown request: " + cmd);
+        } catch (const std::exception& e) {
+            std::string msg = e.what();
+            std::replace(msg.begin(), msg.end(), '\n', ' ');
+            return send_all(fd, "ERROR " + msg + "\n");
+        }
+        cache.trim();
+
+        std::string reply = "OK " + std::to_string(out.size()) + "\n";
+        for (const auto& l : out) reply += l + "\n";
+        return send_all(fd, reply);
+    }
+
+    void serve(int fd)
+    {
+        std::string buf;
+        char chunk[4096];
+        bool open = true;
+
+        while (open && !stopping) {
+            ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            buf.append(chunk, n);
+
+            size_t eol;
+            while (open && (eol = buf.find('\n')) != std::string::npos) {
+                std::string line = buf.substr(0, eol);
+                buf.erase(0, eol + 1);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                open = handle(fd, line);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(conn_m);
+        clients.erase(fd);
+        ::close(fd);
+        conn_done.notify_all();
+    }
+};
+
+} // namespace
+
+
+int run_sfg_daemon(const DaemonOptions& opts)
+{
+    sockaddr_un addr{};
+    if (opts.socket_path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "ERROR: socket path too long: " << opts.socket_path << "\n";
+        return 1;
+    }
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, opts.socket_path.c_str());
+
+    Server server(opts.cache_bytes);
+    server.listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server.listen_fd < 0) {
+        std::cerr << "ERROR: socket: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    // a stale socket file from a previous run would make bind fail; anything
+    // else at that path is not ours to remove
+    struct stat st;
+    if (::lstat(opts.socket_path.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            std::cerr << "ERROR: " << opts.socket_path << " exists and is not a socket\n";
+            ::close(server.listen_fd);
+            return 1;
+        }
+        ::unlink(opts.socket_path.c_str());
+    }
+    if (::bind(server.listen_fd, (sockaddr*)&addr, sizeof(addr)) < 0 ||
+        ::listen(server.listen_fd, 16) < 0) {
+        std::cerr << "ERROR: cannot listen on " << opts.socket_path << ": "
+                  << std::strerror(errno) << "\n";
+        ::close(server.listen_fd);
+        return 1;
+    }
+    ::chmod(opts.socket_path.c_str(), 0600);
+
+    std::cout << "Listening on " << opts.socket_path
+              << " (cache " << (opts.cache_bytes >> 20) << " MB)\n";
+
+    // connections build and sweep sessions concurrently: OpenBLAS stays
+    // single-threaded for the whole daemon, and thread_plan() is serial
+    BlasThreads blas(1);
+
+    while (!server.stopping) {
+        int fd = ::accept(server.listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+
+        std::lock_guard<std::mutex> lock(server.conn_m);
+        if (server.stopping) { ::close(fd); break; }
+        server.clients.insert(fd);
+        std::thread(&Server::serve, &server, fd).detach();
+    }
+
+    // open connections are shut down by stop(); wait for their threads
+    server.stop();
+    {
+        std::unique_lock<std::mutex> lock(server.conn_m);
+        server.conn_done.wait(lock, [&] { return server.clients.empty(); });
+    }
+
+    ::close(server.listen_fd);
+    ::unlink(opts.socket_path.c_str());
+    std::cout << "Daemon stopped\n";
+    return 0;
+}
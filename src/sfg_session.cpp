@@ -0,0 +1,205 @@
+#include "sfg_session.hpp"
+#include "get_amideI_multi.hpp"
+#include "load_R3ZXZ1.hpp"
+#include "apply_R3.hpp"
+#include "compute_SFG_spectra.hpp"
+#include "coupling_model.hpp"
+#include "cn_symmetry.hpp"
+#include "structure_cache.hpp"
+#include "thread_scheduler.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+
+SFGSession::SFGSession(const std::string& input_file)
+    : SFGSession(Read_Input(input_file))
+{
+}
+
+SFGSession::SFGSession(const InputParams& in, std::shared_ptr<R3Database> Rdb,
+                       bool report)
+    : in_(in), report_(report), Rdb_(std::move(Rdb))
+{
+    if (in_.trajectory)
+        throw std::runtime_error("SFGSession: trajectory input is not a static structure "
+                                 "(use run_trajectory_pipeline)");
+
+    // χ elements to evaluate; all 27 only for the debug dumps
+    if (!make_chi2_plan(in_.sfg_elements, in_.debug_output, plan_))
+        throw std::runtime_error("SFGSession: invalid sfg_elements");
+
+    for (double w = in_.spec_range_start; w <= in_.spec_range_end; w += in_.spec_range_step)
+        freq_grid_.push_back(w);
+
+    if (in_.r3_source != "database")
+        Rdb_.reset();
+    else if (!Rdb_)
+        Rdb_ = std::make_shared<R3Database>("./data/R3ZXZ1_database.h5");
+
+    load_structure();
+    solve_excitons();
+}
+
+SFGSession::~SFGSession() = default;
+
+
+// Mode table from the structure cache if it holds this PDB with the same
+// extraction parameters, otherwise from the PDB (and cached)
+void SFGSession::load_structure()
+{
+    const FrequencyMapParams* fmap = in_.freq_map ? &in_.freq_map_params : nullptr;
+    std::string cache_file;
+    uint64_t key = 0;
+    bool cached = false;
+
+    if (in_.structure_cache != "none") {
+        std::filesystem::create_directories(in_.structure_cache);
+        key = structure_cache_key(in_.pdbFile, in_.centerFreq, in_.amide_first,
+                                  in_.amide_last, in_.layer, fmap);
+        if (key != 0) {
+            cache_file = structure_cache_file(in_.structure_cache, key);
+            cached = load_structure_cache(cache_file, key, modes_);
+            if (cached && report_) std::cout << "Sites from cache: " << cache_file << "\n";
+        }
+    }
+
+    if (!cached) {
+        modes_ = Get_AmideI_Multi(in_.centerFreq, in_.amide_first, in_.amide_last,
+                                  in_.layer, in_.pdbFile, fmap, report_);
+
+        if (!cache_file.empty() && save_structure_cache(cache_file, key, modes_) &&
+            report_)
+            std::cout << "Sites cached: " << cache_file << "\n";
+    }
+
+    if (report_)
+        std::cout << "Total modes = " << modes_.N << "\n";
+}
+
+
+// The exciton problem does not depend on the orientation, so it is solved
+// once: a single Hamiltonian, or the static-disorder ensemble through the
+// batched small-N solver
+void SFGSession::solve_excitons()
+{
+    std::unique_ptr<CouplingModel> coupling =
+        make_coupling_model(in_.coupling_model, in_.nn_coupling_map, in_.lattice);
+
+    HamiltonianOptions hopts;
+    hopts.coupling = coupling.get();
+    if (in_.hamiltonian_solver == "lanczos") {
+        hopts.lanczos_steps = in_.lanczos_steps;
+        hopts.tree_theta    = in_.bh_theta;
+    }
+
+    CnSymmetry sym;
+    if (in_.symmetry_n > 1) {
+        if (!detect_cn_symmetry(modes_, in_.symmetry_n, in_.symmetry_axis,
+                                in_.symmetry_tol, sym))
+            throw std::runtime_error("SFGSession: structure is not C" +
+                                     std::to_string(in_.symmetry_n) + " symmetric");
+
+        if (report_)
+            std::cout << "C" << sym.n << " symmetry, axis ("
+                      << sym.axis.x << ", " << sym.axis.y << ", " << sym.axis.z
+                      << "), " << modes_.N / sym.n << " modes per subunit\n";
+        hopts.symmetry = &sym;
+    }
+
+    if (in_.disorder_samples > 1) {
+        auto ensemble = make_disorder_ensemble(modes_.freq, in_.disorder_sigma,
+                                               in_.disorder_samples, in_.disorder_seed);
+        std::vector<HamiltonianBatchItem> batch;
+        for (const auto& f : ensemble)
+            batch.push_back({ &modes_, &f });
+
+        excitons_ = Hamiltonian_equiv_matlab_batch(batch, 0.0, 0.0, hopts);
+    } else {
+        // one eigenproblem: threaded BLAS only from the tuned crossover on
+        BlasThreads blas(thread_plan(modes_.N, 1).blas);
+        excitons_.push_back(Hamiltonian_equiv_matlab(modes_, 0.0, 0.0, hopts));
+    }
+}
+
+
+R3Matrix SFGSession::table_R(double tilt_deg, double twist_deg) const
+{
+    std::lock_guard<std::mutex> lock(R3_mutex_);
+
+    auto& R = R3_cache_[Rdb_->index(twist_deg, tilt_deg)];
+    if (!R) R.reset(new R3Matrix(Rdb_->get_R(twist_deg, tilt_deg)));
+    return *R;
+}
+
+Chi2Result SFGSession::chi2_of(const HamiltonianEquivResult& H,
+                               double tilt_deg, double twist_deg) const
+{
+    if (Rdb_)
+        return compute_chi2_matlab(H, table_R(tilt_deg, twist_deg), plan_);
+    return compute_chi2_matlab(H, make_R3_rotation(twist_deg, tilt_deg), plan_);
+}
+
+
+Chi2Result SFGSession::chi2(double tilt_deg, double twist_deg) const
+{
+    if (excitons_.empty()) return Chi2Result();
+    return chi2_of(excitons_[0], tilt_deg, twist_deg);
+}
+
+
+std::size_t SFGSession::memory_bytes() const
+{
+    const std::size_t d = sizeof(double);
+    std::size_t bytes = sizeof(*this) + (std::size_t)19 * modes_.N * d;
+
+    for (const auto& H : excitons_)
+        bytes += (H.Sort_Ex_Freq.size() + H.Sort_V.size()) * d
+               + H.mu_ex.size() * sizeof(Vec3) + H.alpha_ex.size() * 9 * d
+               + H.mu_rot.size() * sizeof(Vec3) + H.alpha_rot.size() * 9 * d;
+
+    std::lock_guard<std::mutex> lock(R3_mutex_);
+    bytes += R3_cache_.size() * sizeof(R3Matrix);
+    return bytes;
+}
+
+
+void SFGSession::spectrum(double tilt_deg, double twist_deg, double* I) const
+{
+    const int nsel = n_elements();
+    const size_t nf = freq_grid_.size();
+    std::fill(I, I + nsel * nf, 0.0);
+
+    // ensemble average of the intensities
+    for (const auto& H : excitons_)
+    {
+        Chi2Result chi = chi2_of(H, tilt_deg, twist_deg);
+        SpectrumResult s = compute_SFG_spectra(H, chi, in_.width, freq_grid_);
+
+        for (int e = 0; e < nsel; e++)
+            for (size_t i = 0; i < nf; i++)
+                I[e * nf + i] += s.I[e][i];
+    }
+
+    if (excitons_.size() > 1)
+        for (size_t k = 0; k < nsel * nf; k++) I[k] /= excitons_.size();
+}
+
+
+void SFGSession::sweep(const std::vector<double>& tilt_deg,
+                       const std::vector<double>& twist_deg,
+                       double* I) const
+{
+    const int nTilt  = tilt_deg.size();
+    const int nAng   = twist_deg.size() * nTilt;
+    const size_t len = (size_t)n_elements() * freq_grid_.size();
+
+    // orientations are the parallel loop; BLAS calls inside stay serial
+    BlasThreads blas(1);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int a = 0; a < nAng; a++)
+        spectrum(tilt_deg[a % nTilt], twist_deg[a / nTilt], I + a * len);
+}
@@ -0,0 +1,201 @@
+#include "structure_cache.hpp"
+#include "mapped_file.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+
+static const char     CACHE_MAGIC[8] = { 'S', 'F', 'G', 'C', 'A', 'C', 'H', 'E' };
+static const uint32_t CACHE_VERSION  = 2;
+
+struct CacheHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t record_size;    // bytes per mode (layout check)
+    uint64_t key;
+    uint64_t n_modes;
+};
+
+// One mode (one row of the AmideModeTable)
+struct CacheRecord {
+    double center[3];
+    double nn_phi, nn_psi;
+    double mu[3];
+    double alpha[9];         // col-major, as in the table
+    double freq, anharm;
+};
+
+static_assert(sizeof(CacheHeader) == 32, "cache header layout");
+static_assert(sizeof(CacheRecord) == 19 * sizeof(double), "cache record layout");
+
+
+// ---------------------------------------------------------------------------
+// FNV-1a, 64 bit
+// ---------------------------------------------------------------------------
+static const uint64_t FNV_OFFSET = 1469598103934665603ull;
+static const uint64_t FNV_PRIME  = 1099511628211ull;
+
+static uint64_t fnv1a(const void* data, std::size_t n, uint64_t h)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < n; i++) {
+        h ^= p[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+template<typename T>
+static uint64_t fnv1a_value(const T& v, uint64_t h)
+{
+    return fnv1a(&v, sizeof(T), h);
+}
+
+
+uint64_t structure_cache_key(
+    const std::string& pdbFile,
+    double center_freq,
+    int helix_a,
+    int helix_b,
+    int layer,
+    const FrequencyMapParams* freq_map)
+{
+    MappedFile f;
+    if (!f.open(pdbFile)) return 0;
+
+    uint64_t h = fnv1a(f.data(), f.size(), FNV_OFFSET);
+
+    h = fnv1a_value(CACHE_VERSION, h);
+    h = fnv1a_value(center_freq, h);
+    h = fnv1a_value(helix_a, h);
+    h = fnv1a_value(helix_b, h);
+    h = fnv1a_value(layer, h);
+
+    const int has_map = freq_map ? 1 : 0;
+    h = fnv1a_value(has_map, h);
+    if (freq_map) {
+        h = fnv1a_value(freq_map->cutoff, h);
+        h = fnv1a_value(freq_map->coef_C, h);
+        h = fnv1a_value(freq_map->coef_O, h);
+        h = fnv1a_value(freq_map->coef_N, h);
+    }
+
+    return h ? h : 1;   // 0 is reserved for "no key"
+}
+
+
+std::string structure_cache_file(const std::string& dir, uint64_t key)
+{
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)key);
+    return dir + "/" + hex + ".sfgc";
+}
+
+
+bool load_structure_cache(
+    const std::string& file,
+    uint64_t key,
+    AmideModeTable& modes)
+{
+    MappedFile f;
+    if (!f.open(file)) return false;
+
+    CacheHeader hd;
+    if (f.size() < sizeof(hd)) {
+        std::cerr << "WARNING: ignoring truncated structure cache " << file << "\n";
+        return false;
+    }
+    std::memcpy(&hd, f.data(), sizeof(hd));
+
+    if (std::memcmp(hd.magic, CACHE_MAGIC, sizeof(hd.magic)) != 0 ||
+        hd.version != CACHE_VERSION || hd.record_size != sizeof(CacheRecord) ||
+        hd.key != key ||
+        f.size() != sizeof(hd) + hd.n_modes * sizeof(CacheRecord))
+    {
+        std::cerr << "WARNING: ignoring stale or foreign structure cache " << file << "\n";
+        return false;
+    }
+
+    const int N = static_cast<int>(hd.n_modes);
+    modes.resize(N);
+
+    const char* p = f.data() + sizeof(hd);
+    for (int i = 0; i < N; i++, p += sizeof(CacheRecord))
+    {
+        CacheRecord r;
+        std::memcpy(&r, p, sizeof(r));
+
+        modes.x[i] = r.center[0];
+        modes.y[i] = r.center[1];
+        modes.z[i] = r.center[2];
+        modes.nn_phi[i] = r.nn_phi;
+        modes.nn_psi[i] = r.nn_psi;
+        modes.mux[i] = r.mu[0];
+        modes.muy[i] = r.mu[1];
+        modes.muz[i] = r.mu[2];
+        std::memcpy(&modes.alpha[(std::size_t)9 * i], r.alpha, sizeof(r.alpha));
+        modes.freq[i]   = r.freq;
+        modes.anharm[i] = r.anharm;
+    }
+
+    return true;
+}
+
+
+bool save_structure_cache(
+    const std::string& file,
+    uint64_t key,
+    const AmideModeTable& modes)
+{
+    CacheHeader hd;
+    std::memcpy(hd.magic, CACHE_MAGIC, sizeof(hd.magic));
+    hd.version     = CACHE_VERSION;
+    hd.record_size = sizeof(CacheRecord);
+    hd.key         = key;
+    hd.n_modes     = modes.N;
+
+    // unique per writer: batch workers and daemon connections may save the
+    // same structure at the same time, each renaming only its own file
+    static std::atomic<unsigned> n_saves{ 0 };
+    const std::string tmp = file + ".tmp." + std::to_string(getpid()) + "." +
+                            std::to_string(n_saves++);
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(&hd), sizeof(hd));
+
+        for (int i = 0; i < modes.N; i++)
+        {
+            CacheRecord r;
+            r.center[0] = modes.x[i];
+            r.center[1] = modes.y[i];
+            r.center[2] = modes.z[i];
+            r.nn_phi = modes.nn_phi[i];
+            r.nn_psi = modes.nn_psi[i];
+            r.mu[0] = modes.mux[i];
+            r.mu[1] = modes.muy[i];
+            r.mu[2] = modes.muz[i];
+            std::memcpy(r.alpha, modes.alpha_of(i), sizeof(r.alpha));
+            r.freq   = modes.freq[i];
+            r.anharm = modes.anharm[i];
+
+            out.write(reinterpret_cast<const char*>(&r), sizeof(r));
+        }
+
+        if (!out) {
+            std::cerr << "WARNING: cannot write structure cache " << tmp << "\n";
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(tmp.c_str(), file.c_str()) != 0) {
+        std::cerr << "WARNING: cannot write structure cache " << file << "\n";
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
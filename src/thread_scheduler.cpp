@@ -0,0 +1,243 @@
+#include "thread_scheduler.hpp"
+
+#include <cblas.h>
+#include <lapacke.h>
+#include <omp.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+
+// -----------------------------------------------------------------------------
+// OpenBLAS thread count
+// -----------------------------------------------------------------------------
+static int get_blas_threads()
+{
+#ifdef OPENBLAS_VERSION
+    return openblas_get_num_threads();
+#else
+    return 1;
+#endif
+}
+
+static void set_blas_threads(int n)
+{
+#ifdef OPENBLAS_VERSION
+    openblas_set_num_threads(std::max(1, n));
+#else
+    (void)n;
+#endif
+}
+
+static std::mutex blas_m;
+static int blas_depth = 0;      // open BlasThreads scopes
+static int blas_saved = 0;      // count before the outermost one
+
+BlasThreads::BlasThreads(int n)
+{
+    std::lock_guard<std::mutex> lock(blas_m);
+    if (blas_depth++ == 0) {
+        blas_saved = get_blas_threads();
+        if (n != blas_saved) set_blas_threads(n);
+    }
+}
+
+BlasThreads::~BlasThreads()
+{
+    std::lock_guard<std::mutex> lock(blas_m);
+    if (--blas_depth == 0 && get_blas_threads() != blas_saved)
+        set_blas_threads(blas_saved);
+}
+
+static bool blas_pinned()
+{
+    std::lock_guard<std::mutex> lock(blas_m);
+    return blas_depth > 0;
+}
+
+
+// -----------------------------------------------------------------------------
+// Tuning file
+// -----------------------------------------------------------------------------
+static std::string host_name()
+{
+    char buf[256] = {};
+    if (gethostname(buf, sizeof(buf) - 1) != 0) return "localhost";
+    return buf;
+}
+
+std::string thread_tuning_file()
+{
+    if (const char* f = std::getenv("SFG_THREAD_TUNING")) return f;
+    if (const char* h = std::getenv("HOME")) return std::string(h) + "/.sfg_thread_tuning";
+    return ".sfg_thread_tuning";
+}
+
+// Line "host threads crossover" of this machine, or -1
+static int read_crossover(const std::string& host, int threads)
+{
+    std::ifstream fin(thread_tuning_file());
+    std::string line;
+    while (std::getline(fin, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream ss(line);
+        std::string h;
+        int t, c;
+        if (ss >> h >> t >> c && h == host && t == threads) return c;
+    }
+    return -1;
+}
+
+static bool write_crossover(const std::string& host, int threads, int crossover)
+{
+    const std::string fname = thread_tuning_file();
+
+    // keep the entries of other hosts / thread counts (shared home directories)
+    std::vector<std::string> keep;
+    {
+        std::ifstream fin(fname);
+        std::string line;
+        while (std::getline(fin, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            std::istringstream ss(line);
+            std::string h;
+            int t;
+            if (ss >> h >> t && h == host && t == threads) continue;
+            keep.push_back(line);
+        }
+    }
+
+    std::ofstream fout(fname);
+    if (!fout) return false;
+    fout << "# sfg_simulator --tune-threads: host threads crossover_N (0 = never)\n";
+    for (const auto& l : keep) fout << l << "\n";
+    fout << host << " " << threads << " " << crossover << "\n";
+    return true;
+}
+
+static std::mutex crossover_m;
+static int crossover_cached = -1;
+
+int blas_crossover()
+{
+    std::lock_guard<std::mutex> lock(crossover_m);
+    if (crossover_cached < 0) {
+        int c = read_crossover(host_name(), omp_get_max_threads());
+        crossover_cached = (c >= 0) ? c : DEFAULT_BLAS_CROSSOVER;
+    }
+    return crossover_cached;
+}
+
+
+// -----------------------------------------------------------------------------
+// Plan
+// -----------------------------------------------------------------------------
+ThreadPlan thread_plan(int N, int n_tasks)
+{
+    ThreadPlan p;
+    if (omp_in_parallel() || blas_pinned()) return p;   // caller owns the cores
+
+    const int P = omp_get_max_threads();
+    n_tasks = std::max(1, n_tasks);
+    const int C = blas_crossover();
+
+    if (C == 0 || N < C) {
+        p.outer = std::min(P, n_tasks);
+        return p;
+    }
+
+    int blas = 2;
+    for (long n = 2L * C; n <= N && blas < P; n *= 2) blas *= 2;
+    p.blas  = std::min(blas, P);
+    p.outer = std::max(1, std::min(n_tasks, P / p.blas));
+    if (p.outer == n_tasks) p.blas = std::max(p.blas, P / p.outer);
+    return p;
+}
+
+
+// -----------------------------------------------------------------------------
+// Tuning
+// -----------------------------------------------------------------------------
+
+// Symmetric test matrix (column-major, only the upper triangle matters)
+static void test_matrix(int N, unsigned seed, std::vector<double>& A)
+{
+    A.resize((size_t)N * N);
+    unsigned s = seed;
+    for (int j = 0; j < N; j++)
+        for (int i = 0; i <= j; i++) {
+            s = s * 1664525u + 1013904223u;
+            double v = (s >> 8) * (1.0 / 16777216.0) - 0.5;
+            A[(size_t)j * N + i] = A[(size_t)i * N + j] = (i == j) ? v + 1600.0 : v;
+        }
+}
+
+// Best of two runs of P dsyev calls, as P workers or one after another
+static double time_dsyev(int N, int P, bool outer)
+{
+    std::vector<std::vector<double>> A(P), w(P);
+    double best = 1e30;
+
+    for (int rep = 0; rep < 2; rep++)
+    {
+        for (int k = 0; k < P; k++) { test_matrix(N, 17u + k, A[k]); w[k].resize(N); }
+
+        double t0 = omp_get_wtime();
+        if (outer) {
+            BlasThreads blas(1);
+            #pragma omp parallel for num_threads(P) schedule(static, 1)
+            for (int k = 0; k < P; k++)
+                LAPACKE_dsyev(LAPACK_COL_MAJOR, 'V', 'U', N, A[k].data(), N, w[k].data());
+        } else {
+            BlasThreads blas(P);
+            for (int k = 0; k < P; k++)
+                LAPACKE_dsyev(LAPACK_COL_MAJOR, 'V', 'U', N, A[k].data(), N, w[k].data());
+        }
+        best = std::min(best, omp_get_wtime() - t0);
+    }
+    return best;
+}
+
+int tune_blas_crossover(std::ostream& log)
+{
+    const int P = omp_get_max_threads();
+    const std::string host = host_name();
+    int crossover = 0;
+
+    log << "Tuning OpenMP/BLAS crossover on " << host << ", " << P << " threads\n";
+    if (P < 2) {
+        log << "  one thread: nothing to split\n";
+    } else {
+        // inner has to win at two sizes in a row, so that one noisy
+        // timing does not set the crossover; a win at the last size alone
+        // has nothing to confirm it and counts as no crossover
+        int first_win = 0;
+        for (int N = 32; N <= 1024; N *= 2) {
+            double t_outer = time_dsyev(N, P, true);
+            double t_inner = time_dsyev(N, P, false);
+            log << "  N = " << N << ": outer " << t_outer << " s, inner "
+                << t_inner << " s\n";
+
+            if (t_inner >= t_outer) first_win = 0;
+            else if (first_win == 0) first_win = N;
+            else { crossover = first_win; break; }
+        }
+        if (crossover == 0 && first_win != 0)
+            log << "  inner wins only at N = " << first_win << ", unconfirmed\n";
+    }
+
+    if (write_crossover(host, P, crossover))
+        log << "Crossover " << crossover << " written to " << thread_tuning_file() << "\n";
+    else
+        log << "WARNING: cannot write " << thread_tuning_file() << "\n";
+
+    std::lock_guard<std::mutex> lock(crossover_m);
+    crossover_cached = crossover;
+    return crossover;
+}
@@ -0,0 +1,112 @@
+#include "work_stealing_pool.hpp"
+
+#include <chrono>
+#include <thread>
+
+
+static thread_local int tls_worker = -1;
+
+int WorkStealingPool::worker_id()
+{
+    return tls_worker;
+}
+
+
+WorkStealingPool::WorkStealingPool(int n_workers)
+{
+    if (n_workers < 1) n_workers = 1;
+    for (int i = 0; i < n_workers; i++)
+        queues_.emplace_back(new Queue);
+}
+
+void WorkStealingPool::submit(Task task)
+{
+    // own deque from inside a task of this pool, else round-robin
+    int id = tls_worker;
+    if (id < 0 || id >= n_workers())
+        id = static_cast<int>(next_++ % queues_.size());
+
+    pending_++;
+    {
+        std::lock_guard<std::mutex> lock(queues_[id]->m);
+        queues_[id]->q.push_back(std::move(task));
+    }
+    idle_cv_.notify_one();
+}
+
+
+bool WorkStealingPool::pop_local(int id, Task& task)
+{
+    Queue& Q = *queues_[id];
+    std::lock_guard<std::mutex> lock(Q.m);
+    if (Q.q.empty()) return false;
+    task = std::move(Q.q.back());
+    Q.q.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(int id, Task& task)
+{
+    const int n = n_workers();
+    for (int k = 1; k < n; k++) {
+        Queue& Q = *queues_[(id + k) % n];
+        std::lock_guard<std::mutex> lock(Q.m);
+        if (Q.q.empty()) continue;
+        task = std::move(Q.q.front());
+        Q.q.pop_front();
+        steals_++;
+        return true;
+    }
+    return false;
+}
+
+
+void WorkStealingPool::work(int id)
+{
+    tls_worker = id;
+    Task task;
+
+    while (true)
+    {
+        if (pop_local(id, task) || steal(id, task)) {
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_m_);
+                if (!error_) error_ = std::current_exception();
+            }
+            task = nullptr;
+            tasks_run_++;
+
+            if (--pending_ == 0) {
+                std::lock_guard<std::mutex> lock(idle_m_);
+                idle_cv_.notify_all();
+            }
+            continue;
+        }
+
+        // nothing to run: done once no task is pending anywhere, otherwise
+        // a running task may still submit more
+        std::unique_lock<std::mutex> lock(idle_m_);
+        if (pending_ == 0) break;
+        idle_cv_.wait_for(lock, std::chrono::milliseconds(1));
+    }
+
+    tls_worker = -1;
+}
+
+void WorkStealingPool::run()
+{
+    std::vector<std::thread> threads;
+    for (int i = 1; i < n_workers(); i++)
+        threads.emplace_back(&WorkStealingPool::work, this, i);
+
+    work(0);    // the calling thread is worker 0
+    for (auto& t : threads) t.join();
+
+    if (error_) {
+        std::exception_ptr e = error_;
+        error_ = nullptr;
+        std::rethrow_exception(e);
+    }
+}
@@ -0,0 +1,282 @@
+#!/bin/bash
+# make check: regression checks, run from the repository root.
+#
+#   1. input/input.txt on a reduced grid (tilt 0 90 180, twist 0 120 240 360)
+#      against tests/reference, spectra of the original pipeline
+#   2. r3_source = analytic against database on that grid (all angles are
+#      10-degree table entries, so the two must agree)
+#   3. symmetry_n = 5 against the dense solve on a C5 pentamer of the
+#      P450 fragment B:28-147 (amide_range = all)
+#   4. hamiltonian_solver = lanczos (bh_theta = 0) against dense on the whole
+#      P450 chain (461 modes): 39 block steps span every state, 20 steps keep
+#      a reduced set of 240
+#   5. disorder_samples = 70 (batched Jacobi, N = 16) against one dsyev; with
+#      disorder_sigma = 0 every realization is the same Hamiltonian
+#   6. --batch against sfg_simulator run on its own, byte for byte
+#   7. structure_cache hit against miss, byte for byte
+#   8. a chain break and an insertion code: extracted mode count, and the
+#      insertion code does not change the spectra
+#   9. trajectory = yes on a one-model file against the static run
+#  10. sfg.Session against sfg_simulator, and the Chi2Plan elements against
+#      the full chi_lab; skipped without python/sfg.so (make python)
+#  11. sfg_simulator_mpi --batch on 1 rank against MPI_RANKS ranks, byte for
+#      byte; skipped without the MPI build (make mpi) or $MPIRUN
+#
+# Spectra compare equal if the headers match and every value is within
+# TOL (or the given tolerance) of the largest value of the compared set.
+
+SIM=${SIM:-./sfg_simulator}
+SIM_MPI=${SIM_MPI:-./sfg_simulator_mpi}
+MPIRUN=${MPIRUN:-mpirun}
+MPI_RANKS=${MPI_RANKS:-2}
+TOL=1e-6
+REF=tests/reference
+
+cd "$(dirname "$0")/.." || exit 1
+
+work=$(mktemp -d) || exit 1
+trap 'rm -rf "$work"' EXIT
+failed=0
+
+ok()   { echo "PASS: $1"; }
+fail() { echo "FAIL: $1"; failed=1; }
+
+# same_spectrum <a> <b> [tol]: '#' lines equal, numbers within tol
+same_spectrum() {
+    awk -v tol="${3:-$TOL}" '
+        NR == FNR { a[FNR] = $0; na = FNR; next }
+        { b[FNR] = $0; nb = FNR }
+        END {
+            if (na != nb) exit 1
+            big = 0; diff = 0
+            for (i = 1; i <= na; i++) {
+                if (a[i] ~ /^#/ || b[i] ~ /^#/) { if (a[i] != b[i]) exit 1; continue }
+                n = split(a[i], x); if (split(b[i], y) != n) exit 1
+                for (k = 1; k <= n; k++) {
+                    d = x[k] - y[k]; if (d < 0) d = -d
+                    v = x[k] < 0 ? -x[k] : x[k]
+                    if (d > diff) diff = d
+                    if (k > 1 && v > big) big = v
+                }
+            }
+            exit (diff > tol * big)
+        }' "$1" "$2"
+}
+
+# same_spectra <dir_a> <dir_b> [tol]: every file of dir_a, and nothing else,
+# in dir_b; compared as one set, so near-zero orientations do not count alone
+same_spectra() {
+    local n=0 f
+    : > "$work/set_a"; : > "$work/set_b"
+    for f in "$1"/*.txt; do
+        [ -f "$2/${f##*/}" ] || { echo "  missing: ${f##*/}"; return 1; }
+        cat "$f" >> "$work/set_a"
+        cat "$2/${f##*/}" >> "$work/set_b"
+        n=$((n + 1))
+    done
+    [ "$n" -gt 0 ] && [ "$(ls "$2" | wc -l)" -eq "$n" ] &&
+        same_spectrum "$work/set_a" "$work/set_b" "$3"
+}
+
+# cn_assembly <n> <last_residue> <pdb>: n copies of the chain up to
+# last_residue, copy p rotated by 2 pi p / n about the z axis, which is put
+# 45 A from the centroid (as a BIOMT assembly; chains A, B, ...)
+cn_assembly() {
+    awk -v n="$1" -v last="$2" '
+        /^ATOM  / && substr($0, 23, 4) + 0 <= last {
+            line[++na] = $0
+            x[na] = substr($0, 31, 8); y[na] = substr($0, 39, 8); z[na] = substr($0, 47, 8)
+            cx += x[na]; cy += y[na]
+        }
+        END {
+            cx /= na; cy /= na; pi = atan2(0, -1)
+            for (p = 0; p < n; p++) {
+                c = cos(2 * pi * p / n); s = sin(2 * pi * p / n)
+                for (i = 1; i <= na; i++) {
+                    u = x[i] - cx + 45; v = y[i] - cy
+                    printf "%s%s%s%8.3f%8.3f%8.3f%s\n", substr(line[i], 1, 21),
+                           substr("ABCDEFGH", p + 1, 1), substr(line[i], 23, 8),
+                           c * u - s * v, s * u + c * v, z[i], substr(line[i], 55)
+                }
+                print "TER"
+            }
+            print "END"
+        }' "$3"
+}
+
+# broken_chain <icode> <pdb>: residues 28-40 without 38, so that 37 and 39
+# are not bonded; with icode set, residue 35 becomes 34<icode>
+broken_chain() {
+    awk -v ic="$1" '
+        /^ATOM  / {
+            r = substr($0, 23, 4) + 0
+            if (r < 28 || r > 40 || r == 38) next
+            if (r == 35 && ic != "") $0 = substr($0, 1, 22) "  34" ic substr($0, 28)
+            print
+        }
+        END { print "END" }' "$2"
+}
+
+# run_cli <dir> [key=value ...]: sfg_simulator in <dir> on input/input.txt
+# with the given keys appended (later keys win); spectra in <dir>/output_spectra
+run_cli() {
+    local d=$1; shift
+    mkdir -p "$d/input" && ln -s "$PWD/data" "$d/data" || return 1
+    { tr -d '\r' < input/input.txt
+      printf '%s\n' "PDB_file=$PWD/complex_144w_90_40_P450.pdb" "$@"; } > "$d/input/input.txt"
+    (cd "$d" && "$SIM_PATH") > "$d/log" 2>&1 || { cat "$d/log"; return 1; }
+}
+
+if [ ! -x "$SIM" ]; then
+    echo "FAIL: $SIM not built (make)"
+    exit 1
+fi
+SIM_PATH=$(cd "$(dirname "$SIM")" && pwd)/${SIM##*/}
+
+GRID="tilt_points=3 twist_points=4"
+cat > "$work/jobs.txt" <<EOF
+input/input.txt "SpectraFolder=$work/analytic" r3_source=analytic $GRID
+input/input.txt "SpectraFolder=$work/database" r3_source=database $GRID
+EOF
+
+cn_assembly 5 147 complex_144w_90_40_P450.pdb > "$work/c5.pdb"
+cat > "$work/models.txt" <<EOF
+input/input.txt "PDB_file=$work/c5.pdb" "SpectraFolder=$work/c5_dense" amide_range=all $GRID
+input/input.txt "PDB_file=$work/c5.pdb" "SpectraFolder=$work/c5_sym" amide_range=all symmetry_n=5 $GRID
+input/input.txt "SpectraFolder=$work/p450_dense" amide_range=all $GRID
+input/input.txt "SpectraFolder=$work/p450_lz39" amide_range=all hamiltonian_solver=lanczos bh_theta=0 lanczos_steps=39 $GRID
+input/input.txt "SpectraFolder=$work/p450_lz20" amide_range=all hamiltonian_solver=lanczos bh_theta=0 lanczos_steps=20 $GRID
+input/input.txt "SpectraFolder=$work/n16_dsyev" "amide_range=1 16" $GRID
+input/input.txt "SpectraFolder=$work/n16_jacobi" "amide_range=1 16" disorder_samples=70 $GRID
+EOF
+
+if "$SIM" --batch "$work/jobs.txt" > "$work/batch.log" 2>&1; then
+    same_spectra "$REF" "$work/analytic" &&
+        ok "default input against $REF" ||
+        fail "default input against $REF"
+    same_spectra "$work/analytic" "$work/database" &&
+        ok "analytic against database R3" ||
+        fail "analytic against database R3"
+else
+    cat "$work/batch.log"
+    fail "sfg_simulator --batch"
+fi
+
+# the assembly has 3 decimals per coordinate, so it is symmetric to ~1e-3 A
+if "$SIM" --batch "$work/models.txt" > "$work/models.log" 2>&1; then
+    same_spectra "$work/c5_dense" "$work/c5_sym" 1e-5 &&
+        ok "C5 symmetry against dense (595 modes)" ||
+        fail "C5 symmetry against dense"
+    for k in 39 20; do
+        same_spectra "$work/p450_dense" "$work/p450_lz$k" &&
+            ok "lanczos ($k steps) against dense (461 modes)" ||
+            fail "lanczos ($k steps) against dense"
+    done
+    # 70 = one full Jacobi batch of 64 and a partial one
+    same_spectra "$work/n16_dsyev" "$work/n16_jacobi" &&
+        ok "batched Jacobi ensemble against dsyev (16 modes)" ||
+        fail "batched Jacobi ensemble against dsyev"
+else
+    cat "$work/models.log"
+    fail "sfg_simulator --batch (models)"
+fi
+
+# the "analytic" job of jobs.txt on its own
+run_cli "$work/cli" $GRID &&
+    diff -r "$work/analytic" "$work/cli/output_spectra" > /dev/null &&
+    ok "--batch against a single run, byte-identical" ||
+    fail "--batch against a single run"
+
+run_cli "$work/sc_miss" "structure_cache=$work/sc" $GRID &&
+    run_cli "$work/sc_hit" "structure_cache=$work/sc" $GRID &&
+    grep -q "^Sites cached:" "$work/sc_miss/log" &&
+    grep -q "^Sites from cache:" "$work/sc_hit/log" &&
+    diff -r "$work/sc_miss/output_spectra" "$work/sc_hit/output_spectra" > /dev/null &&
+    ok "structure cache hit against miss, byte-identical" ||
+    fail "structure cache hit against miss"
+
+# 12 residues, 10 amides: 28-37 bonded through 34, 34A and 36, then 39-40
+broken_chain "" complex_144w_90_40_P450.pdb > "$work/plain.pdb"
+broken_chain A complex_144w_90_40_P450.pdb > "$work/icode.pdb"
+run_cli "$work/plain" "PDB_file=$work/plain.pdb" amide_range=all $GRID &&
+    run_cli "$work/icode" "PDB_file=$work/icode.pdb" amide_range=all $GRID &&
+    grep -q "^Chain B: 12 residues, 10 amide-I modes" "$work/icode/log" &&
+    grep -q "chain break between B:[A-Z]* 37 and B:[A-Z]* 39 " "$work/icode/log" &&
+    diff -r "$work/plain/output_spectra" "$work/icode/output_spectra" > /dev/null &&
+    ok "chain break and insertion code (10 modes)" ||
+    fail "chain break and insertion code"
+
+# the trajectory average carries one more '#' line
+{ echo "MODEL        1"; grep "^ATOM" complex_144w_90_40_P450.pdb; echo "ENDMDL"; } \
+    > "$work/one_model.pdb"
+if run_cli "$work/traj" "PDB_file=$work/one_model.pdb" trajectory=yes \
+        write_frame_spectra=no amide_range=all $GRID; then
+    mkdir "$work/traj_avg"
+    for f in "$work/traj/output_spectra"/*.txt; do
+        grep -v "^# time average" "$f" > "$work/traj_avg/${f##*/}"
+    done
+    same_spectra "$work/p450_dense" "$work/traj_avg" &&
+        ok "one-frame trajectory against static (461 modes)" ||
+        fail "one-frame trajectory against static"
+else
+    fail "sfg_simulator (trajectory)"
+fi
+
+if [ ! -f python/sfg.so ] || ! command -v python3 > /dev/null; then
+    echo "SKIP: sfg.Session against sfg_simulator (needs make python)"
+else
+    # the session reads the input run_cli wrote
+    if ! run_cli "$work/elem" debug_output=yes "sfg_elements=ssp sps pss ppp xzx" $GRID; then
+        fail "sfg_simulator (sfg_elements)"
+    elif PYTHONPATH=python python3 - "$work/elem/input/input.txt" \
+            "$work/elem/output_spectra" "$TOL" <<'EOF'
+import os, re, sys
+import sfg
+
+inp, out, tol = sys.argv[1], sys.argv[2], float(sys.argv[3])
+s = sfg.Session(inp)
+
+# chi_lab[k][i][j][l] is tensor element "ijl"; labels are SSP(yyz) or xzx
+elem = [re.sub(r".*\((.*)\)", r"\1", l) for l in s.labels]
+idx = [[ord(c) - ord("x") for c in e] for e in elem]
+
+d_spec = big_spec = d_chi = big_chi = 0.0
+for f in sorted(os.listdir(out)):
+    tilt, twist = map(float, re.search(r"_tilt(\d+)_twist(\d+)", f).groups())
+    I = s.spectrum(tilt, twist).tolist()
+    rows = [l.split() for l in open(os.path.join(out, f)) if not l.startswith("#")]
+    for i, r in enumerate(rows):
+        for e in range(len(elem)):
+            d_spec = max(d_spec, abs(float(r[e + 1]) - I[e][i]))
+            big_spec = max(big_spec, abs(I[e][i]))
+
+    c = s.chi2(tilt, twist)
+    chi, lab = c["chi"].tolist(), c["chi_lab"].tolist()
+    for k in range(len(chi)):
+        for e, (a, b, g) in enumerate(idx):
+            d_chi = max(d_chi, abs(chi[k][e] - lab[k][a][b][g]))
+            big_chi = max(big_chi, abs(lab[k][a][b][g]))
+
+print("  spectra %.2e, chi %.2e (relative)" % (d_spec / big_spec, d_chi / big_chi))
+sys.exit(d_spec > tol * big_spec or d_chi > tol * big_chi)
+EOF
+    then
+        ok "sfg.Session against sfg_simulator, plan elements against chi_lab"
+    else
+        fail "sfg.Session against sfg_simulator"
+    fi
+fi
+
+if [ ! -x "$SIM_MPI" ] || ! command -v "${MPIRUN%% *}" > /dev/null; then
+    echo "SKIP: MPI 1 rank against $MPI_RANKS (needs $SIM_MPI and $MPIRUN)"
+else
+    for n in 1 "$MPI_RANKS"; do
+        OMP_NUM_THREADS=1 $MPIRUN -n "$n" "$SIM_MPI" --batch "$work/jobs.txt" \
+            "$work/mpi$n.txt" > "$work/mpi$n.log" 2>&1 || cat "$work/mpi$n.log"
+    done
+    [ -s "$work/mpi1.txt" ] && cmp -s "$work/mpi1.txt" "$work/mpi$MPI_RANKS.txt" &&
+        ok "MPI 1 rank against $MPI_RANKS, byte-identical" ||
+        fail "MPI 1 rank against $MPI_RANKS"
+fi
+
+exit $failed